@@ -0,0 +1,71 @@
+/*
+ * Created by kureii on 11/15/24.
+ */
+
+// Replaces the global operator new and delete to count allocations into the
+// instrumentation sink. Only linked into programs that ask for it, see the
+// diff_evo_allocation_hook target.
+
+#include <cstdlib>
+#include <new>
+
+#include "instrumentation.h"
+
+namespace {
+
+// Counts every allocation made while a sink is installed, which includes
+// the ones done by the objective.
+void *CountedNew(std::size_t size, std::size_t alignment) {
+  if (auto *counters = instrument::Sink()) ++counters->allocations;
+  if (size == 0) size = 1;
+  const auto aligned = alignment > __STDCPP_DEFAULT_NEW_ALIGNMENT__;
+  // aligned_alloc takes whole multiples of the alignment only
+  if (aligned) size = (size + alignment - 1) / alignment * alignment;
+  for (;;) {
+    if (auto *p = aligned ? std::aligned_alloc(alignment, size)
+                          : std::malloc(size)) {
+      return p;
+    }
+    auto handler = std::get_new_handler();
+    if (!handler) throw std::bad_alloc();
+    handler();
+  }
+}
+
+}  // namespace
+
+void *operator new(std::size_t size) {
+  return CountedNew(size, __STDCPP_DEFAULT_NEW_ALIGNMENT__);
+}
+void *operator new(std::size_t size, std::align_val_t alignment) {
+  return CountedNew(size, static_cast<std::size_t>(alignment));
+}
+void *operator new(std::size_t size, const std::nothrow_t &) noexcept {
+  try {
+    return CountedNew(size, __STDCPP_DEFAULT_NEW_ALIGNMENT__);
+  } catch (const std::bad_alloc &) {
+    return nullptr;
+  }
+}
+void *operator new(std::size_t size, std::align_val_t alignment,
+                   const std::nothrow_t &) noexcept {
+  try {
+    return CountedNew(size, static_cast<std::size_t>(alignment));
+  } catch (const std::bad_alloc &) {
+    return nullptr;
+  }
+}
+
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete(void *p, std::size_t) noexcept { std::free(p); }
+void operator delete(void *p, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void *p, std::size_t, std::align_val_t) noexcept {
+  std::free(p);
+}
+void operator delete(void *p, const std::nothrow_t &) noexcept {
+  std::free(p);
+}
+void operator delete(void *p, std::align_val_t,
+                     const std::nothrow_t &) noexcept {
+  std::free(p);
+}
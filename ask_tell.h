@@ -0,0 +1,88 @@
+/*
+ * Created by kureii on 11/15/24.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <random>
+#include <span>
+#include <vector>
+
+#include "de_policies.h"
+#include "structures.h"
+
+enum class AskTellMode {
+  // a generation is swapped in once every one of its trials has been told
+  kGenerational,
+  // a trial replaces its target individual as soon as it is told
+  kSteadyState,
+};
+
+// Candidate handed out by AskTell::Ask. `weight` stays valid and unchanged
+// until the matching Tell.
+struct ask_candidate_structure {
+  size_t id;
+  std::span<const double> weight;
+};
+
+using ask_candidate_t = ask_candidate_structure;
+
+// DE driven from outside: Ask hands out vectors to evaluate, Tell reports
+// their cost, in any order and from any thread. The initial population is
+// handed out first. Each individual has at most one trial in flight, so
+// Ask returns std::nullopt while every slot waits for its Tell.
+template <typename MUTATION, typename CROSSOVER = BinomialCrossover>
+class AskTell {
+  // ask/tell keeps its population size and has no hook for a selection or
+  // reduction step between generations
+  static_assert(
+      !requires(MUTATION &mutation, std::mt19937 &gen, pop_t &population) {
+        mutation.EndGeneration(gen, population, population, size_t{});
+      },
+      "mutation policies with an EndGeneration, such as LshadeMutation, "
+      "need DiffEvoEngine");
+
+ public:
+  AskTell(const pop_t &initial_population, limits_t limits, MUTATION mutation,
+          CROSSOVER crossover, AskTellMode mode, uint64_t seed);
+
+  AskTell(const AskTell &) = delete;
+  AskTell &operator=(const AskTell &) = delete;
+
+  std::optional<ask_candidate_t> Ask();
+  void Tell(size_t id, double cost);
+
+  // Current best individual, its cost is DBL_MAX until the initial
+  // population has been evaluated.
+  [[nodiscard]] de_t Best() const;
+  [[nodiscard]] size_t Evaluations() const;
+  [[nodiscard]] size_t Generation() const;
+
+ private:
+  MUTATION mutation_;
+  CROSSOVER crossover_;
+  limits_t limits_;
+  AskTellMode mode_;
+  std::mt19937 gen_;
+
+  mutable std::mutex mutex_;
+  pop_t population_;
+  // row j holds the vector handed out for slot j
+  pop_t trials_;
+  std::vector<bool> busy_;
+  size_t next_slot_ = 0;
+  size_t asked_ = 0;
+  size_t told_ = 0;
+  bool initialized_ = false;
+  size_t evaluations_ = 0;
+  size_t generation_ = 0;
+
+  void BuildTrial(size_t slot);
+  void FinishGeneration();
+  void UpdateBest(size_t slot);
+};
+
+#include "ask_tell.tpp"
@@ -0,0 +1,142 @@
+#pragma once
+
+#include <algorithm>
+#include <cfloat>
+#include <stdexcept>
+#include <utility>
+
+template <typename MUTATION, typename CROSSOVER>
+AskTell<MUTATION, CROSSOVER>::AskTell(const pop_t &initial_population,
+                                      limits_t limits, MUTATION mutation,
+                                      CROSSOVER crossover, AskTellMode mode,
+                                      uint64_t seed)
+    : mutation_(std::move(mutation)),
+      crossover_(std::move(crossover)),
+      limits_(std::move(limits)),
+      mode_(mode),
+      gen_(static_cast<std::mt19937::result_type>(seed)),
+      population_(initial_population),
+      trials_(initial_population),
+      busy_(initial_population.size, false) {
+  if (population_.size < 4) {
+    throw std::invalid_argument("population needs at least 4 individuals");
+  }
+  for (size_t j = 0; j < trials_.size; ++j) {
+    ClampToLimits(trials_.Row(j), limits_.min.data(), limits_.max.data());
+  }
+  std::ranges::fill(population_.costs, DBL_MAX);
+}
+
+template <typename MUTATION, typename CROSSOVER>
+std::optional<ask_candidate_t> AskTell<MUTATION, CROSSOVER>::Ask() {
+  std::lock_guard lock(mutex_);
+
+  const auto size = population_.size;
+  if (!initialized_ || mode_ == AskTellMode::kGenerational) {
+    // every slot is handed out once per (initial) generation
+    if (asked_ == size) return std::nullopt;
+    const auto slot = asked_++;
+    if (initialized_) BuildTrial(slot);
+    busy_[slot] = true;
+    return ask_candidate_t{slot, trials_.Row(slot)};
+  }
+
+  for (size_t k = 0; k < size; ++k) {
+    const auto slot = next_slot_;
+    next_slot_ = (next_slot_ + 1) % size;
+    if (busy_[slot]) continue;
+
+    BuildTrial(slot);
+    busy_[slot] = true;
+    return ask_candidate_t{slot, trials_.Row(slot)};
+  }
+  return std::nullopt;
+}
+
+template <typename MUTATION, typename CROSSOVER>
+void AskTell<MUTATION, CROSSOVER>::Tell(size_t id, double cost) {
+  std::lock_guard lock(mutex_);
+
+  if (id >= population_.size || !busy_[id]) {
+    throw std::invalid_argument("id was not handed out by Ask or already told");
+  }
+  busy_[id] = false;
+  trials_.costs[id] = cost;
+  ++evaluations_;
+
+  if (!initialized_ || mode_ == AskTellMode::kGenerational) {
+    if (++told_ == population_.size) FinishGeneration();
+    return;
+  }
+
+  std::ranges::copy(trials_.Row(id), population_.Row(id).begin());
+  population_.costs[id] = cost;
+  UpdateBest(id);
+
+  // steady state counts a generation per population size of evaluations
+  if (++told_ == population_.size) {
+    told_ = 0;
+    ++generation_;
+  }
+}
+
+template <typename MUTATION, typename CROSSOVER>
+de_t AskTell<MUTATION, CROSSOVER>::Best() const {
+  std::lock_guard lock(mutex_);
+
+  de_t best;
+  best.cost = population_.costs[population_.best];
+  const auto row = population_.Row(population_.best);
+  best.weight.assign(row.begin(), row.end());
+  return best;
+}
+
+template <typename MUTATION, typename CROSSOVER>
+size_t AskTell<MUTATION, CROSSOVER>::Evaluations() const {
+  std::lock_guard lock(mutex_);
+  return evaluations_;
+}
+
+template <typename MUTATION, typename CROSSOVER>
+size_t AskTell<MUTATION, CROSSOVER>::Generation() const {
+  std::lock_guard lock(mutex_);
+  return generation_;
+}
+
+template <typename MUTATION, typename CROSSOVER>
+void AskTell<MUTATION, CROSSOVER>::BuildTrial(size_t slot) {
+  // jDE style policies draw their parameters once per (virtual) generation
+  if (slot == 0) mutation_.BeginGeneration(gen_, population_.size);
+
+  auto trial = trials_.Row(slot);
+  const auto params = mutation_.Params(slot);
+  const auto base = mutation_.Mutate(population_, slot, params, gen_, trial);
+  crossover_.Cross(trial, std::as_const(population_).Row(base),
+                   params.cross_rate, gen_);
+  ClampToLimits(trial, limits_.min.data(), limits_.max.data());
+}
+
+template <typename MUTATION, typename CROSSOVER>
+void AskTell<MUTATION, CROSSOVER>::FinishGeneration() {
+  std::swap(population_.weights, trials_.weights);
+  std::swap(population_.costs, trials_.costs);
+  population_.best = static_cast<size_t>(
+      std::ranges::min_element(population_.costs) - population_.costs.begin());
+
+  if (initialized_) ++generation_;
+  initialized_ = true;
+  asked_ = 0;
+  told_ = 0;
+}
+
+template <typename MUTATION, typename CROSSOVER>
+void AskTell<MUTATION, CROSSOVER>::UpdateBest(size_t slot) {
+  if (population_.costs[slot] < population_.costs[population_.best]) {
+    population_.best = slot;
+  } else if (slot == population_.best) {
+    // the best was replaced by something worse, look for the new one
+    population_.best = static_cast<size_t>(
+        std::ranges::min_element(population_.costs) -
+        population_.costs.begin());
+  }
+}
@@ -0,0 +1,412 @@
+/*
+ * Created by kureii on 11/15/24.
+ */
+
+// Performance benchmark of the DiffEvo strategies, independent of the
+// plotting driver. Every case prints one JSON object per line to stdout:
+//
+//   {"strategy": "rand1", "function": "rastrigin", "precision": "double",
+//    "dim": 10, "pop": 100, "threads": 4, "generations": 50,
+//    "evaluations": 5100, "seconds": ..., "evals_per_sec": ...,
+//    "gens_per_sec": ..., "best_cost": ...,
+//    "time_to_target": ... | null, "peak_rss_kb": ... | null,
+//    "instrumentation": {...}}
+//
+// instrumentation, see ToJson in instrumentation.h, is only there in builds
+// with DIFF_EVO_INSTRUMENT, which also count allocations.
+//
+// Options (comma separated lists):
+//   --strategies rand1,best1,jde,lshade
+//   --functions sphere,rastrigin,...
+//   --dims 2,10,100,1000           --pops 20,100,1000,5000
+//   --threads 1,8                  --generations 50
+//   --target 1e-6                  --seed 2024
+//   --precisions double,float,mixed
+//   --quick                        small sweep for smoke runs
+//
+// peak_rss_kb is the high water mark of the resident set during the case,
+// reset before it through /proc/self/clear_refs and read from VmHWM, null
+// where Linux does not offer either. The shifted and rotated functions only
+// run in double precision. Sphere, rosenbrock and schwefel evaluate twice as
+// many individuals per instruction in float as in double, mixed evaluates
+// them row by row, and the other functions are row by row in every
+// precision.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <format>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "diff_evo.h"
+#include "test_functions.h"
+
+namespace {
+
+using clock_type = std::chrono::steady_clock;
+
+// Rotation matrices grow with dim^2 and their product with dim^2 per
+// individual, above this the rotated functions are skipped.
+constexpr size_t kMaxRotatedDim = 100;
+
+// The target and three distinct donors, DiffEvo::Optimize returns nothing
+// for smaller populations.
+constexpr size_t kMinPop = 4;
+
+struct function_structure {
+  std::string name;
+  double min;
+  double max;
+  // built for a dimension and seed, nullptr when the case is skipped
+  std::function<std::unique_ptr<test_functions::ShiftedRotated>(size_t,
+                                                                uint64_t)>
+      shifted;
+  test_functions::batch_function_t batch;
+  // float genes with float and double costs, nullptr for double only
+  void (*single)(float_pop_view_t, std::span<float>) = nullptr;
+  void (*mixed)(float_pop_view_t, std::span<double>) = nullptr;
+};
+
+using function_t = function_structure;
+
+struct options_structure {
+  std::vector<std::string> strategies{"rand1", "best1", "jde", "lshade"};
+  std::vector<std::string> functions{
+      "sphere",   "rosenbrock", "rastrigin",         "ackley",
+      "griewank", "schwefel",   "shifted_rastrigin", "rotated_rastrigin"};
+  std::vector<size_t> dims{2, 10, 100, 1000};
+  std::vector<size_t> pops{20, 100, 1000, 5000};
+  std::vector<size_t> threads{
+      1, std::max(1u, std::thread::hardware_concurrency())};
+  std::vector<std::string> precisions{"double"};
+  size_t generations = 50;
+  double target = 1e-6;
+  uint64_t seed = 2024;
+};
+
+using options_t = options_structure;
+
+std::vector<std::string> Split(const std::string &list) {
+  std::vector<std::string> items;
+  size_t begin = 0;
+  while (begin <= list.size()) {
+    const auto end = std::min(list.find(',', begin), list.size());
+    if (end > begin) items.push_back(list.substr(begin, end - begin));
+    begin = end + 1;
+  }
+  return items;
+}
+
+std::vector<size_t> SplitSizes(const std::string &list) {
+  std::vector<size_t> sizes;
+  for (const auto &item : Split(list)) {
+    sizes.push_back(std::stoull(item));
+  }
+  return sizes;
+}
+
+options_t ParseOptions(int argc, char **argv) {
+  options_t options;
+  for (int i = 1; i < argc; ++i) {
+    const std::string arg = argv[i];
+    if (arg == "--quick") {
+      options.dims = {2, 10, 30};
+      options.pops = {20, 100};
+      options.threads = {1, 2};
+      options.generations = 20;
+      continue;
+    }
+    if (i + 1 >= argc) {
+      throw std::invalid_argument(std::format("missing value for {}", arg));
+    }
+    const std::string value = argv[++i];
+    if (arg == "--strategies") {
+      options.strategies = Split(value);
+    } else if (arg == "--functions") {
+      options.functions = Split(value);
+    } else if (arg == "--dims") {
+      options.dims = SplitSizes(value);
+    } else if (arg == "--pops") {
+      options.pops = SplitSizes(value);
+      for (const auto pop : options.pops) {
+        if (pop < kMinPop) {
+          throw std::invalid_argument(
+              std::format("--pops needs at least {} individuals, got {}",
+                          kMinPop, pop));
+        }
+      }
+    } else if (arg == "--threads") {
+      options.threads = SplitSizes(value);
+    } else if (arg == "--precisions") {
+      options.precisions = Split(value);
+    } else if (arg == "--generations") {
+      options.generations = std::stoull(value);
+    } else if (arg == "--target") {
+      options.target = std::stod(value);
+    } else if (arg == "--seed") {
+      options.seed = std::stoull(value);
+    } else {
+      throw std::invalid_argument(std::format("unknown option {}", arg));
+    }
+  }
+  return options;
+}
+
+function_t MakeFunction(const std::string &name) {
+  using test_functions::ShiftedRotated;
+  auto shifted = [](test_functions::batch_function_t base, double min,
+                    double max, bool rotate) {
+    return [=](size_t dim, uint64_t seed) -> std::unique_ptr<ShiftedRotated> {
+      if (rotate && dim > kMaxRotatedDim) return nullptr;
+      return std::make_unique<ShiftedRotated>(base, dim, min, max, seed,
+                                              rotate);
+    };
+  };
+
+  if (name == "sphere") {
+    return {name, -5.12, 5.12, nullptr, test_functions::SphareBatch,
+            test_functions::SphareBatchFloat<float>,
+            test_functions::SphareBatchFloat<double>};
+  }
+  if (name == "rosenbrock") {
+    return {name, -5.0, 10.0, nullptr, test_functions::RosenbrockBatch,
+            test_functions::RosenbrockBatchFloat<float>,
+            test_functions::RosenbrockBatchFloat<double>};
+  }
+  if (name == "rastrigin") {
+    return {name, -5.12, 5.12, nullptr, test_functions::RastriginBatch,
+            test_functions::RastriginBatchFloat<float>,
+            test_functions::RastriginBatchFloat<double>};
+  }
+  if (name == "ackley") {
+    return {name, -32.768, 32.768, nullptr, test_functions::AckleyBatch,
+            test_functions::AckleyBatchFloat<float>,
+            test_functions::AckleyBatchFloat<double>};
+  }
+  if (name == "griewank") {
+    return {name, -600.0, 600.0, nullptr, test_functions::GriewankBatch,
+            test_functions::GriewankBatchFloat<float>,
+            test_functions::GriewankBatchFloat<double>};
+  }
+  if (name == "schwefel") {
+    return {name, -500.0, 500.0, nullptr, test_functions::SchefelBatch,
+            test_functions::SchefelBatchFloat<float>,
+            test_functions::SchefelBatchFloat<double>};
+  }
+  if (name == "shifted_rastrigin") {
+    return {name, -5.12, 5.12,
+            shifted(test_functions::RastriginBatch, -4.0, 4.0, false),
+            nullptr};
+  }
+  if (name == "rotated_rastrigin") {
+    return {name, -5.12, 5.12,
+            shifted(test_functions::RastriginBatch, -4.0, 4.0, true),
+            nullptr};
+  }
+  if (name == "rotated_ackley") {
+    return {name, -32.768, 32.768,
+            shifted(test_functions::AckleyBatch, -30.0, 30.0, true), nullptr};
+  }
+  if (name == "rotated_griewank") {
+    return {name, -600.0, 600.0,
+            shifted(test_functions::GriewankBatch, -580.0, 580.0, true),
+            nullptr};
+  }
+  throw std::invalid_argument(std::format("unknown function {}", name));
+}
+
+// JSON has no infinity or NaN, such values are written as null.
+std::string JsonNumber(double value, std::string_view format) {
+  if (!std::isfinite(value)) return "null";
+  return std::vformat(format, std::make_format_args(value));
+}
+
+// Lowers the high water mark of the resident set to the current size.
+bool ResetPeakRss() {
+  std::ofstream clear_refs("/proc/self/clear_refs");
+  clear_refs << "5" << std::flush;
+  return clear_refs.good();
+}
+
+// VmHWM of the process in kB, -1 when it cannot be read.
+long PeakRssKb() {
+  std::ifstream status("/proc/self/status");
+  std::string line;
+  while (std::getline(status, line)) {
+    if (line.starts_with("VmHWM:")) return std::stol(line.substr(6));
+  }
+  return -1;
+}
+
+// Wraps a batch objective and notes the first time a cost below `target`
+// is seen. Called from several threads at once.
+template <typename FUN>
+struct target_watch_structure {
+  FUN fun;
+  double target;
+  clock_type::time_point start;
+  std::atomic<int64_t> *reached_ns;
+
+  template <typename VIEW, typename COST>
+  void operator()(VIEW population, std::span<COST> costs) const {
+    fun(population, costs);
+    const auto best = std::ranges::min(costs.first(population.size));
+    if (best < target && reached_ns->load(std::memory_order_relaxed) < 0) {
+      int64_t expected = -1;
+      reached_ns->compare_exchange_strong(
+          expected, (clock_type::now() - start).count(),
+          std::memory_order_relaxed);
+    }
+  }
+};
+
+// Same parameters as DiffEvo::Rand1, Best1, jDE and LShade in the given
+// precision.
+template <typename PRECISION, typename FUN>
+std::vector<de_t> RunStrategy(DiffEvo &de, const std::string &strategy,
+                              size_t iterations, FUN fun) {
+  constexpr auto kDim = std::dynamic_extent;
+  if (strategy == "rand1") {
+    return de.Optimize<kDim, PRECISION>(
+        iterations, Rand1Mutation{{0.5, 0.8}}, BinomialCrossover{}, fun);
+  }
+  if (strategy == "best1") {
+    return de.Optimize<kDim, PRECISION>(
+        iterations, Best1Mutation{{0.5, 0.8}}, BinomialCrossover{}, fun);
+  }
+  if (strategy == "jde") {
+    return de.Optimize<kDim, PRECISION>(
+        iterations, JdeMutation{{0.5, 0.9}, 0.1, 0.1, {}},
+        BinomialCrossover{}, fun);
+  }
+  if (strategy == "lshade") {
+    return de.Optimize<kDim, PRECISION>(
+        iterations, LshadeMutation{iterations},
+        BinomialCrossover{.force_mutant_gene = true}, fun);
+  }
+  throw std::invalid_argument(std::format("unknown strategy {}", strategy));
+}
+
+template <typename PRECISION, typename FUN>
+void RunCase(const options_t &options, const std::string &strategy,
+             const function_t &function, const std::string &precision,
+             size_t dim, size_t pop, size_t threads, const FUN &fun) {
+  DiffEvo de(options.seed);
+  de.GenerateInitPopulation(dim, pop);
+  de.AddMinLimits(function.min);
+  de.AddMaxLimits(function.max);
+  de.SetThreads(threads);
+
+  const bool peak_reset = ResetPeakRss();
+  const auto iterations = pop * (options.generations + 1);
+  std::atomic<int64_t> reached_ns = -1;
+  const auto start = clock_type::now();
+  const auto output = RunStrategy<PRECISION>(
+      de, strategy, iterations,
+      target_watch_structure<std::reference_wrapper<const FUN>>{
+          std::cref(fun), options.target, start, &reached_ns});
+  const std::chrono::duration<double> elapsed = clock_type::now() - start;
+
+  auto best = std::numeric_limits<double>::infinity();
+  for (const auto &record : output) {
+    best = std::min(best, record.cost);
+  }
+  const auto generations = output.size();
+  const auto evaluations = de.GetEvaluations();
+  const auto seconds = elapsed.count();
+  const auto reached = reached_ns.load();
+  const auto peak_rss = peak_reset ? PeakRssKb() : -1;
+
+  std::cout << std::format(
+      R"({{"strategy": "{}", "function": "{}", "precision": "{}", )"
+      R"("dim": {}, "pop": {}, "threads": {}, "generations": {}, )"
+      R"("evaluations": {}, )"
+      R"("seconds": {:.6f}, "evals_per_sec": {}, "gens_per_sec": {}, )"
+      R"("best_cost": {}, "time_to_target": {}, "peak_rss_kb": {})",
+      strategy, function.name, precision, dim, pop, threads, generations,
+      evaluations, seconds,
+      JsonNumber(static_cast<double>(evaluations) / seconds, "{:.1f}"),
+      JsonNumber(static_cast<double>(generations) / seconds, "{:.3f}"),
+      JsonNumber(best, "{:.10g}"),
+      reached < 0 ? std::string("null")
+                  : std::format("{:.6f}", static_cast<double>(reached) * 1e-9),
+      peak_rss < 0 ? std::string("null") : std::to_string(peak_rss));
+  if constexpr (instrument::kEnabled) {
+    std::cout << R"(, "instrumentation": )" << ToJson(de.GetInstrumentation());
+  }
+  std::cout << "}" << std::endl;
+}
+
+void RunPrecision(const options_t &options, const std::string &strategy,
+                  const function_t &function, const std::string &precision,
+                  size_t dim, size_t pop, size_t threads,
+                  const test_functions::ShiftedRotated *shifted) {
+  if (precision == "double") {
+    if (shifted) {
+      RunCase<double_precision_t>(options, strategy, function, precision, dim,
+                                  pop, threads, *shifted);
+    } else {
+      RunCase<double_precision_t>(options, strategy, function, precision, dim,
+                                  pop, threads, function.batch);
+    }
+  } else if (precision == "float") {
+    if (!function.single) return;
+    RunCase<single_precision_t>(options, strategy, function, precision, dim,
+                                pop, threads, function.single);
+  } else if (precision == "mixed") {
+    if (!function.mixed) return;
+    RunCase<mixed_precision_t>(options, strategy, function, precision, dim,
+                               pop, threads, function.mixed);
+  } else {
+    throw std::invalid_argument(std::format("unknown precision {}", precision));
+  }
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  try {
+    const auto options = ParseOptions(argc, argv);
+
+    std::vector<function_t> functions;
+    for (const auto &name : options.functions) {
+      functions.push_back(MakeFunction(name));
+    }
+
+    for (const auto &function : functions) {
+      for (const auto dim : options.dims) {
+        std::unique_ptr<test_functions::ShiftedRotated> shifted;
+        if (function.shifted) {
+          shifted = function.shifted(dim, options.seed);
+          if (!shifted) continue;
+        }
+        for (const auto pop : options.pops) {
+          for (const auto threads : options.threads) {
+            for (const auto &strategy : options.strategies) {
+              for (const auto &precision : options.precisions) {
+                RunPrecision(options, strategy, function, precision, dim, pop,
+                             threads, shifted.get());
+              }
+            }
+          }
+        }
+      }
+    }
+  } catch (const std::exception &e) {
+    std::cerr << e.what() << std::endl;
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,161 @@
+/*
+ * Created by kureii on 11/15/24.
+ */
+
+#include "convergence_log.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstring>
+#include <format>
+#include <stdexcept>
+#include <utility>
+
+using convergence_log::header_structure;
+using convergence_log::record_structure;
+
+ConvergenceWriter::ConvergenceWriter(const std::string &path, size_t dim,
+                                     bool with_genome)
+    : file_(path, std::ios::binary | std::ios::trunc),
+      path_(path),
+      dim_(dim),
+      with_genome_(with_genome) {
+  if (!file_.is_open()) {
+    throw std::runtime_error(std::format("Unable to open file: {}", path));
+  }
+
+  header_structure header{};
+  std::memcpy(header.magic, convergence_log::kMagic, sizeof(header.magic));
+  header.version = convergence_log::kVersion;
+  header.flags = with_genome_ ? convergence_log::kWithGenome : 0;
+  header.dim = dim_;
+  file_.write(reinterpret_cast<const char *>(&header), sizeof(header));
+  if (!file_) {
+    throw std::runtime_error(std::format("Unable to write file: {}", path_));
+  }
+}
+
+void ConvergenceWriter::Append(uint64_t generation, uint64_t evaluations,
+                               double best_cost,
+                               std::span<const double> genome) {
+  // checked first, a record without its genome would shift all later ones
+  if (with_genome_ && genome.size() != dim_) {
+    throw std::invalid_argument("genome size does not match the log");
+  }
+
+  const record_structure record{generation, evaluations, best_cost};
+  file_.write(reinterpret_cast<const char *>(&record), sizeof(record));
+  if (with_genome_) {
+    file_.write(reinterpret_cast<const char *>(genome.data()),
+                static_cast<std::streamsize>(genome.size_bytes()));
+  }
+  if (!file_) {
+    throw std::runtime_error(std::format("Unable to write file: {}", path_));
+  }
+}
+
+bool ConvergenceWriter::WithGenome() const { return with_genome_; }
+
+ConvergenceLog::ConvergenceLog(const std::string &path) {
+  const auto fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    throw std::runtime_error(std::format("Unable to open file: {}", path));
+  }
+
+  struct stat st {};
+  if (fstat(fd, &st) != 0 ||
+      static_cast<size_t>(st.st_size) < sizeof(header_structure)) {
+    close(fd);
+    throw std::runtime_error(std::format("{} is not a convergence log", path));
+  }
+
+  bytes_ = static_cast<size_t>(st.st_size);
+  auto *mapped = mmap(nullptr, bytes_, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (mapped == MAP_FAILED) {
+    throw std::runtime_error(std::format("Unable to map file: {}", path));
+  }
+  data_ = static_cast<const unsigned char *>(mapped);
+
+  header_structure header{};
+  std::memcpy(&header, data_, sizeof(header));
+  // a genome longer than the file cannot be real, and checking that first
+  // keeps the record size from overflowing
+  const auto dim_fits = header.dim <= bytes_ / sizeof(double);
+  dim_ = dim_fits ? header.dim : 0;
+  with_genome_ = (header.flags & convergence_log::kWithGenome) != 0;
+  record_bytes_ =
+      sizeof(record_structure) + (with_genome_ ? dim_ * sizeof(double) : 0);
+  if (std::memcmp(header.magic, convergence_log::kMagic,
+                  sizeof(header.magic)) != 0 ||
+      header.version != convergence_log::kVersion || !dim_fits ||
+      record_bytes_ == 0) {
+    munmap(const_cast<unsigned char *>(data_), bytes_);
+    throw std::runtime_error(
+        std::format("{} is not a version {} convergence log", path,
+                    convergence_log::kVersion));
+  }
+
+  // a record cut short by a killed writer is ignored
+  size_ = (bytes_ - sizeof(header_structure)) / record_bytes_;
+}
+
+ConvergenceLog::~ConvergenceLog() {
+  if (data_) munmap(const_cast<unsigned char *>(data_), bytes_);
+}
+
+ConvergenceLog::ConvergenceLog(ConvergenceLog &&other) noexcept
+    : data_(std::exchange(other.data_, nullptr)),
+      bytes_(std::exchange(other.bytes_, 0)),
+      dim_(other.dim_),
+      with_genome_(other.with_genome_),
+      record_bytes_(other.record_bytes_),
+      size_(std::exchange(other.size_, 0)) {}
+
+ConvergenceLog &ConvergenceLog::operator=(ConvergenceLog &&other) noexcept {
+  if (this != &other) {
+    if (data_) munmap(const_cast<unsigned char *>(data_), bytes_);
+    data_ = std::exchange(other.data_, nullptr);
+    bytes_ = std::exchange(other.bytes_, 0);
+    dim_ = other.dim_;
+    with_genome_ = other.with_genome_;
+    record_bytes_ = other.record_bytes_;
+    size_ = std::exchange(other.size_, 0);
+  }
+  return *this;
+}
+
+size_t ConvergenceLog::Size() const { return size_; }
+
+size_t ConvergenceLog::Dim() const { return dim_; }
+
+bool ConvergenceLog::WithGenome() const { return with_genome_; }
+
+uint64_t ConvergenceLog::Generation(size_t record) const {
+  return Record(record)->generation;
+}
+
+uint64_t ConvergenceLog::Evaluations(size_t record) const {
+  return Record(record)->evaluations;
+}
+
+double ConvergenceLog::Cost(size_t record) const {
+  return Record(record)->best_cost;
+}
+
+std::span<const double> ConvergenceLog::Genome(size_t record) const {
+  if (!with_genome_) return {};
+  return {reinterpret_cast<const double *>(Record(record) + 1), dim_};
+}
+
+const record_structure *ConvergenceLog::Record(size_t record) const {
+  if (record >= size_) {
+    throw std::out_of_range(
+        std::format("record {} of a log with {}", record, size_));
+  }
+  return reinterpret_cast<const record_structure *>(
+      data_ + sizeof(header_structure) + record * record_bytes_);
+}
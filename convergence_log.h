@@ -0,0 +1,97 @@
+/*
+ * Created by kureii on 11/15/24.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <fstream>
+#include <span>
+#include <string>
+
+// Append-only binary log of one run, one fixed size record per generation:
+//
+//   header  magic "DECONVLG", uint32 version, uint32 flags, uint64 dim,
+//           uint64 reserved
+//   record  uint64 generation, uint64 evaluations, double best_cost,
+//           double best_genome[dim] (only with kWithGenome)
+//
+// Everything is little endian and 8 byte aligned, so ConvergenceLog can map
+// the file and read records in place.
+namespace convergence_log {
+
+inline constexpr char kMagic[8] = {'D', 'E', 'C', 'O', 'N', 'V', 'L', 'G'};
+inline constexpr uint32_t kVersion = 1;
+inline constexpr uint32_t kWithGenome = 1;
+
+struct header_structure {
+  char magic[8];
+  uint32_t version;
+  uint32_t flags;
+  uint64_t dim;
+  uint64_t reserved;
+};
+
+struct record_structure {
+  uint64_t generation;
+  uint64_t evaluations;
+  double best_cost;
+};
+
+}  // namespace convergence_log
+
+class ConvergenceWriter {
+ public:
+  ConvergenceWriter(const std::string &path, size_t dim, bool with_genome);
+
+  ConvergenceWriter(const ConvergenceWriter &) = delete;
+  ConvergenceWriter &operator=(const ConvergenceWriter &) = delete;
+
+  // `genome` is ignored unless the log was opened with_genome. Throws
+  // std::runtime_error when writing fails, which the buffering of the stream
+  // can delay by a few records.
+  void Append(uint64_t generation, uint64_t evaluations, double best_cost,
+              std::span<const double> genome);
+
+  [[nodiscard]] bool WithGenome() const;
+
+ private:
+  std::ofstream file_;
+  std::string path_;
+  size_t dim_;
+  bool with_genome_;
+};
+
+// Read-only memory mapped view of a file written by ConvergenceWriter.
+class ConvergenceLog {
+ public:
+  explicit ConvergenceLog(const std::string &path);
+  ~ConvergenceLog();
+
+  ConvergenceLog(ConvergenceLog &&other) noexcept;
+  ConvergenceLog &operator=(ConvergenceLog &&other) noexcept;
+  ConvergenceLog(const ConvergenceLog &) = delete;
+  ConvergenceLog &operator=(const ConvergenceLog &) = delete;
+
+  [[nodiscard]] size_t Size() const;
+  [[nodiscard]] size_t Dim() const;
+  [[nodiscard]] bool WithGenome() const;
+
+  // Records past Size() throw std::out_of_range.
+  [[nodiscard]] uint64_t Generation(size_t record) const;
+  [[nodiscard]] uint64_t Evaluations(size_t record) const;
+  [[nodiscard]] double Cost(size_t record) const;
+  // Empty unless the log was written with_genome.
+  [[nodiscard]] std::span<const double> Genome(size_t record) const;
+
+ private:
+  const unsigned char *data_ = nullptr;
+  size_t bytes_ = 0;
+  size_t dim_ = 0;
+  bool with_genome_ = false;
+  size_t record_bytes_ = 0;
+  size_t size_ = 0;
+
+  [[nodiscard]] const convergence_log::record_structure *Record(
+      size_t record) const;
+};
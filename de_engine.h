@@ -0,0 +1,244 @@
+/*
+ * Created by kureii on 11/15/24.
+ */
+
+#pragma once
+
+#include <concepts>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "convergence_log.h"
+#include "de_policies.h"
+#include "delta_objective.h"
+#include "instrumentation.h"
+#include "parallel_runner.h"
+#include "philox.h"
+#include "snapshot.h"
+#include "structures.h"
+
+// Objective evaluating a single individual and storing its cost in it.
+template <typename FUN>
+concept IndividualObjective = std::invocable<FUN, de_t *>;
+
+// Objective evaluating a block of individuals at once, costs[i] receives the
+// cost of population.Row(i). Genes and costs have the types of PRECISION.
+template <typename FUN, typename PRECISION = double_precision_t>
+concept BatchObjective =
+    std::invocable<FUN,
+                   population_view_structure<typename PRECISION::scalar_type>,
+                   std::span<typename PRECISION::cost_type>> &&
+    !IndividualObjective<FUN>;
+
+template <typename FUN, typename PRECISION = double_precision_t>
+concept Objective =
+    IndividualObjective<FUN> || BatchObjective<FUN, PRECISION>;
+
+// Generator family with one independent stream per
+// (seed, run, generation, individual), see Philox4x32.
+template <typename RNG>
+concept StreamRng =
+    std::uniform_random_bit_generator<RNG> &&
+    std::constructible_from<RNG, uint64_t, uint32_t, uint32_t, uint32_t> &&
+    requires {
+      { RNG::kGenerationStream } -> std::convertible_to<uint32_t>;
+      { RNG::kSelectionStream } -> std::convertible_to<uint32_t>;
+    };
+
+// Stream family whose streams can be produced for many individuals at once
+// and then read through RNG::BufferedStream.
+template <typename RNG>
+concept BufferedStreamRng =
+    StreamRng<RNG> && requires(uint32_t *out) {
+      typename RNG::BufferedStream;
+      RNG::FillStreams(uint64_t{}, uint32_t{}, uint32_t{}, uint32_t{},
+                       size_t{}, size_t{}, out);
+    };
+
+// Generational DE loop shared by all strategies. The strategy itself is
+// supplied by the mutation and crossover policies (see de_policies.h); DIM
+// fixes the dimension at compile time, which stores every individual as a
+// std::array and unrolls the per-gene loops. Child j of generation g draws
+// from the RNG stream (seed, run, g, j), so results do not depend on how the
+// generation is split among threads.
+//
+// PRECISION sets the gene and cost types (see precision_structure). With
+// float genes the population and bounds take half the memory and the gene
+// loops twice the SIMD lanes, the interface stays in double: initial
+// populations, limits, snapshots and reported individuals are converted.
+// Individual objectives always see double genes.
+template <typename MUTATION, typename CROSSOVER = BinomialCrossover,
+          size_t DIM = std::dynamic_extent, StreamRng RNG = Philox4x32,
+          typename PRECISION = double_precision_t>
+class DiffEvoEngine {
+ public:
+  using scalar_t = typename PRECISION::scalar_type;
+  using cost_t = typename PRECISION::cost_type;
+  using population_t =
+      std::conditional_t<DIM == std::dynamic_extent,
+                         population_structure<scalar_t, cost_t>,
+                         fixed_population_structure<DIM, scalar_t, cost_t>>;
+
+  // `runner` may be nullptr to run on the calling thread, it has to outlive
+  // the engine otherwise. Engines sharing a seed need distinct `run`s to get
+  // independent streams.
+  DiffEvoEngine(MUTATION mutation, CROSSOVER crossover, const limits_t &limits,
+                uint64_t seed, ParallelRunner *runner = nullptr,
+                uint32_t run = 0);
+
+  // Copies, clamps and evaluates the initial population.
+  template <typename FUN>
+    requires Objective<FUN, PRECISION>
+  void Init(const pop_t &initial_population, FUN &fun);
+
+  // Builds, evaluates and swaps in one generation.
+  template <typename FUN>
+    requires Objective<FUN, PRECISION>
+  void Step(FUN &fun);
+
+  // Init followed by generations until `iterations` evaluations are spent,
+  // returns the best individual of every generation.
+  template <typename FUN>
+    requires Objective<FUN, PRECISION>
+  std::vector<de_t> Run(const pop_t &initial_population, size_t iterations,
+                        FUN &fun);
+
+  // Same as Run, but every generation is appended to `log` instead of being
+  // kept in memory.
+  template <typename FUN>
+    requires Objective<FUN, PRECISION>
+  void Run(const pop_t &initial_population, size_t iterations, FUN &fun,
+           ConvergenceWriter &log);
+
+  // Runs generations after Init or Restore until `iterations` evaluations
+  // are spent in total.
+  template <typename FUN>
+    requires Objective<FUN, PRECISION>
+  std::vector<de_t> Continue(size_t iterations, FUN &fun);
+  template <typename FUN>
+    requires Objective<FUN, PRECISION>
+  void Continue(size_t iterations, FUN &fun, ConvergenceWriter &log);
+
+  // Writes a snapshot to `path` after every `interval` generations of Run and
+  // Continue, an empty path or 0 turns it off.
+  void SetCheckpoint(std::string path, size_t interval);
+  void Save(const std::string &path) const;
+  // Takes over the state, seed and run of a snapshot in place of Init. The
+  // following generations are bit identical to those of the saved engine,
+  // given the same policies and objective.
+  void Restore(const snapshot_view_t &snapshot);
+
+  [[nodiscard]] const population_t &Population() const;
+  [[nodiscard]] size_t Evaluations() const;
+  [[nodiscard]] size_t Generation() const;
+  // Copies the current best individual into a record sized for it.
+  void RecordBest(de_t &record) const;
+  // Appends records sized for RecordBest, one per generation left until
+  // `iterations` evaluations are spent. Exact unless the mutation policy
+  // shrinks the population, a loop that runs out calls it again.
+  void ReserveRecords(std::vector<de_t> &records, size_t iterations) const;
+  // Replaces the worst individual by `weight` when `cost` is lower.
+  void Immigrate(std::span<const double> weight, double cost);
+  // Counters since the last Init, all zero unless built with
+  // DIFF_EVO_INSTRUMENT.
+  [[nodiscard]] instrumentation_t Instrumentation() const;
+
+ private:
+  MUTATION mutation_;
+  CROSSOVER crossover_;
+  limits_structure<scalar_t> limits_;
+  ParallelRunner *runner_;
+  uint64_t seed_;
+  uint32_t run_;
+  // the kSnapshotTag of MUTATION, 0 for policies without one
+  static constexpr uint32_t kStrategyTag = [] {
+    if constexpr (requires { MUTATION::kSnapshotTag; }) {
+      return uint32_t{MUTATION::kSnapshotTag};
+    } else {
+      return uint32_t{0};
+    }
+  }();
+  // per chunk stream words of up to kStreamGroup children, blocks_ blocks
+  // each
+  static constexpr size_t kStreamGroup = 16;
+  size_t blocks_ = 0;
+  std::vector<std::vector<uint32_t>> words_;
+  std::vector<de_t> scratch_;
+  std::vector<size_t> chunk_best_;
+  // per chunk genes a child changed, for DeltaObjective
+  std::vector<std::vector<size_t>> changed_;
+  // per chunk children the delta left to a full evaluation, copied together
+  // so batch objectives get up to kDeferredGroup of them per call
+  static constexpr size_t kDeferredGroup = 32;
+  std::vector<population_t> deferred_;
+  std::vector<std::vector<size_t>> deferred_rows_;
+  static constexpr size_t kFullEvaluationInterval = 16;
+  // per chunk, the serial parts of a generation go to the first one
+  std::vector<instrumentation_t> stats_;
+
+  // double buffer, children are written to Next() and swapped in
+  population_t buffers_[2];
+  size_t current_ = 0;
+  size_t evaluations_ = 0;
+  size_t generation_ = 0;
+  std::string checkpoint_path_;
+  size_t checkpoint_interval_ = 0;
+
+  population_t &Current() { return buffers_[current_]; }
+  population_t &Next() { return buffers_[current_ ^ 1]; }
+
+  template <typename TASK>
+  void ForEachChunk(size_t count, TASK &&task);
+
+  void Clamp(std::span<scalar_t, DIM> weight) const;
+
+  // Sizes the per-chunk buffers for `size` x `dim` and clears the counters.
+  void Prepare(size_t size, size_t dim);
+  void Checkpoint() const;
+
+  // Whether CROSSOVER lists the genes it keeps from the mutant.
+  static constexpr bool kListsMutantGenes =
+      requires(const CROSSOVER &crossover, std::span<scalar_t, DIM> trial,
+               std::span<const scalar_t, DIM> base, RNG &gen,
+               std::vector<size_t> &genes) {
+        crossover.Cross(trial, base, 0.0, gen, genes);
+      };
+
+  // Builds children [begin, end) of `next` from `current`, calling
+  // done(child, base) after each of them. With `mutant_genes` a crossover
+  // that can lists the genes each child kept from the mutant there.
+  template <typename DONE>
+  void BuildChildren(const population_t &current, population_t &next,
+                     size_t begin, size_t end, std::vector<uint32_t> &words,
+                     std::vector<size_t> *mutant_genes, DONE &&done);
+
+  // Sets the cost of child j of `next` from the cost of its crossover base
+  // and the genes in `changed`. Returns false, leaving the cost alone, when
+  // most genes changed and a full evaluation is cheaper.
+  template <typename FUN>
+  bool DeltaCost(FUN &fun, const population_t &current, size_t base,
+                 population_t &next, size_t j, std::vector<size_t> &changed);
+  // Queues child j for a full evaluation with the other children of its
+  // chunk that DeltaCost turned down, a full group is evaluated at once.
+  template <typename FUN>
+  void Defer(FUN &fun, population_t &next, size_t j, size_t chunk);
+  // Evaluates the queued children of `chunk` and sets their costs in `next`.
+  template <typename FUN>
+  void EvaluateDeferred(FUN &fun, population_t &next, size_t chunk);
+
+  [[nodiscard]] size_t BestRow(const population_t &population, size_t begin,
+                               size_t end) const;
+
+  // Evaluates rows [begin, end) and returns the index of the best of them.
+  template <typename FUN>
+  size_t EvaluateRows(FUN &fun, population_t &population, size_t begin,
+                      size_t end, de_t &scratch);
+
+  // Combines the per-chunk best indices into population.best.
+  void MergeBest(population_t &population);
+};
+
+#include "de_engine.tpp"
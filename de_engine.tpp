@@ -0,0 +1,603 @@
+#pragma once
+
+#include <algorithm>
+#include <cfloat>
+#include <limits>
+#include <stdexcept>
+
+template <typename MUTATION, typename CROSSOVER, size_t DIM, StreamRng RNG,
+          typename PRECISION>
+DiffEvoEngine<MUTATION, CROSSOVER, DIM, RNG, PRECISION>::DiffEvoEngine(
+    MUTATION mutation, CROSSOVER crossover, const limits_t &limits,
+    uint64_t seed, ParallelRunner *runner, uint32_t run)
+    : mutation_(std::move(mutation)),
+      crossover_(std::move(crossover)),
+      limits_{{limits.min.begin(), limits.min.end()},
+              {limits.max.begin(), limits.max.end()}},
+      runner_(runner),
+      seed_(seed),
+      run_(run) {}
+
+template <typename MUTATION, typename CROSSOVER, size_t DIM, StreamRng RNG,
+          typename PRECISION>
+const typename DiffEvoEngine<MUTATION, CROSSOVER, DIM, RNG,
+                             PRECISION>::population_t &
+DiffEvoEngine<MUTATION, CROSSOVER, DIM, RNG, PRECISION>::Population() const {
+  return buffers_[current_];
+}
+
+template <typename MUTATION, typename CROSSOVER, size_t DIM, StreamRng RNG,
+          typename PRECISION>
+size_t
+DiffEvoEngine<MUTATION, CROSSOVER, DIM, RNG, PRECISION>::Evaluations() const {
+  return evaluations_;
+}
+
+template <typename MUTATION, typename CROSSOVER, size_t DIM, StreamRng RNG,
+          typename PRECISION>
+size_t
+DiffEvoEngine<MUTATION, CROSSOVER, DIM, RNG, PRECISION>::Generation() const {
+  return generation_;
+}
+
+template <typename MUTATION, typename CROSSOVER, size_t DIM, StreamRng RNG,
+          typename PRECISION>
+instrumentation_t
+DiffEvoEngine<MUTATION, CROSSOVER, DIM, RNG, PRECISION>::Instrumentation()
+    const {
+  instrumentation_t total;
+  for (const auto &stats : stats_) {
+    total += stats;
+  }
+  return total;
+}
+
+template <typename MUTATION, typename CROSSOVER, size_t DIM, StreamRng RNG,
+          typename PRECISION>
+void DiffEvoEngine<MUTATION, CROSSOVER, DIM, RNG, PRECISION>::RecordBest(
+    de_t &record) const {
+  DIFF_EVO_PHASE(kReporting);
+  const auto &population = Population();
+  const auto best = population.Row(population.best);
+  record.cost = population.costs[population.best];
+  std::ranges::copy(best, record.weight.begin());
+}
+
+template <typename MUTATION, typename CROSSOVER, size_t DIM, StreamRng RNG,
+          typename PRECISION>
+void DiffEvoEngine<MUTATION, CROSSOVER, DIM, RNG, PRECISION>::ReserveRecords(
+    std::vector<de_t> &records, size_t iterations) const {
+  const auto &population = Population();
+  const auto size = population.size;
+  const auto generations =
+      iterations > evaluations_ ? (iterations - evaluations_ + size - 1) / size
+                                : 0;
+  const auto first = records.size();
+  records.resize(first + generations);
+  for (auto g = first; g < records.size(); ++g) {
+    records[g].weight.resize(population.Row(0).size());
+  }
+}
+
+template <typename MUTATION, typename CROSSOVER, size_t DIM, StreamRng RNG,
+          typename PRECISION>
+void DiffEvoEngine<MUTATION, CROSSOVER, DIM, RNG, PRECISION>::Immigrate(
+    std::span<const double> weight, double cost) {
+  auto &population = Current();
+  const auto worst = static_cast<size_t>(
+      std::ranges::max_element(population.costs) - population.costs.begin());
+  const auto converted = static_cast<cost_t>(cost);
+  if (!(converted < population.costs[worst])) return;
+
+  std::ranges::copy(weight, population.Row(worst).begin());
+  population.costs[worst] = converted;
+  if (converted < population.costs[population.best]) {
+    population.best = worst;
+  }
+}
+
+template <typename MUTATION, typename CROSSOVER, size_t DIM, StreamRng RNG,
+          typename PRECISION>
+template <typename FUN>
+  requires Objective<FUN, PRECISION>
+void DiffEvoEngine<MUTATION, CROSSOVER, DIM, RNG, PRECISION>::Init(
+    const pop_t &initial_population, FUN &fun) {
+  if (initial_population.size < 4) {
+    throw std::invalid_argument("population needs at least 4 individuals");
+  }
+  if (DIM != std::dynamic_extent && initial_population.dim != DIM) {
+    throw std::invalid_argument(
+        "initial_population size does not match the engine dimension");
+  }
+  Prepare(initial_population.size, initial_population.dim);
+  DIFF_EVO_SINK(stats_[0]);
+
+  if constexpr (std::same_as<population_t, pop_t>) {
+    buffers_[0] = initial_population;
+  } else {
+    buffers_[0].Resize(initial_population.size, initial_population.dim);
+    for (size_t j = 0; j < initial_population.size; ++j) {
+      std::ranges::copy(initial_population.Row(j),
+                        buffers_[0].Row(j).begin());
+    }
+    buffers_[0].costs.assign(initial_population.costs.begin(),
+                             initial_population.costs.end());
+  }
+  buffers_[1] = buffers_[0];
+  current_ = 0;
+  evaluations_ = 0;
+  generation_ = 0;
+
+  auto &population = Current();
+  ForEachChunk(population.size, [&](size_t chunk, size_t begin, size_t end) {
+    DIFF_EVO_SINK(stats_[chunk]);
+    for (size_t j = begin; j < end; ++j) {
+      Clamp(population.Row(j));
+    }
+    chunk_best_[chunk] =
+        EvaluateRows(fun, population, begin, end, scratch_[chunk]);
+  });
+  MergeBest(population);
+  evaluations_ += population.size;
+}
+
+template <typename MUTATION, typename CROSSOVER, size_t DIM, StreamRng RNG,
+          typename PRECISION>
+template <typename FUN>
+  requires Objective<FUN, PRECISION>
+void DiffEvoEngine<MUTATION, CROSSOVER, DIM, RNG, PRECISION>::Step(FUN &fun) {
+  const auto &current = Current();
+  auto &next = Next();
+  const auto size = current.size;
+  const auto generation = static_cast<uint32_t>(generation_ + 1);
+  DIFF_EVO_SINK(stats_[0]);
+
+  {
+    DIFF_EVO_PHASE(kMutation);
+    RNG gen(seed_, run_, generation, RNG::kGenerationStream);
+    if constexpr (requires { mutation_.BeginGeneration(gen, current); }) {
+      mutation_.BeginGeneration(gen, current);
+    } else {
+      mutation_.BeginGeneration(gen, size);
+    }
+  }
+
+  ForEachChunk(current.size, [&](size_t chunk, size_t begin, size_t end) {
+    DIFF_EVO_SINK(stats_[chunk]);
+    if constexpr (DeltaObjective<FUN, PRECISION>) {
+      // incremental costs drift, every few generations are evaluated in full
+      if ((generation_ + 1) % kFullEvaluationInterval != 0) {
+        BuildChildren(current, next, begin, end, words_[chunk],
+                      &changed_[chunk], [&](size_t j, size_t base) {
+                        if (!DeltaCost(fun, current, base, next, j,
+                                       changed_[chunk])) {
+                          Defer(fun, next, j, chunk);
+                        }
+                      });
+        EvaluateDeferred(fun, next, chunk);
+        chunk_best_[chunk] = BestRow(next, begin, end);
+        return;
+      }
+    }
+    BuildChildren(current, next, begin, end, words_[chunk], nullptr,
+                  [](size_t, size_t) {});
+    chunk_best_[chunk] = EvaluateRows(fun, next, begin, end, scratch_[chunk]);
+  });
+  MergeBest(next);
+  evaluations_ += size;
+
+  if constexpr (requires(RNG &gen) {
+                  mutation_.EndGeneration(gen, current, next, evaluations_);
+                }) {
+    DIFF_EVO_PHASE(kSelection);
+    RNG gen(seed_, run_, generation, RNG::kSelectionStream);
+    mutation_.EndGeneration(gen, current, next, evaluations_);
+    // both buffers follow a shrinking population, neither reallocates
+    Current().Resize(next.size, next.Row(0).size());
+    next.best = BestRow(next, 0, next.size);
+  }
+
+  current_ ^= 1;
+  ++generation_;
+}
+
+template <typename MUTATION, typename CROSSOVER, size_t DIM, StreamRng RNG,
+          typename PRECISION>
+template <typename FUN>
+  requires Objective<FUN, PRECISION>
+std::vector<de_t> DiffEvoEngine<MUTATION, CROSSOVER, DIM, RNG, PRECISION>::Run(
+    const pop_t &initial_population, size_t iterations, FUN &fun) {
+  Init(initial_population, fun);
+  return Continue(iterations, fun);
+}
+
+template <typename MUTATION, typename CROSSOVER, size_t DIM, StreamRng RNG,
+          typename PRECISION>
+template <typename FUN>
+  requires Objective<FUN, PRECISION>
+void DiffEvoEngine<MUTATION, CROSSOVER, DIM, RNG, PRECISION>::Run(
+    const pop_t &initial_population, size_t iterations, FUN &fun,
+    ConvergenceWriter &log) {
+  Init(initial_population, fun);
+  Continue(iterations, fun, log);
+}
+
+template <typename MUTATION, typename CROSSOVER, size_t DIM, StreamRng RNG,
+          typename PRECISION>
+template <typename FUN>
+  requires Objective<FUN, PRECISION>
+std::vector<de_t>
+DiffEvoEngine<MUTATION, CROSSOVER, DIM, RNG, PRECISION>::Continue(
+    size_t iterations, FUN &fun) {
+  std::vector<de_t> output;
+  ReserveRecords(output, iterations);
+
+  size_t g = 0;
+  while (evaluations_ < iterations) {
+    if (g == output.size()) ReserveRecords(output, iterations);
+    Step(fun);
+    DIFF_EVO_SINK(stats_[0]);
+    RecordBest(output[g++]);
+    Checkpoint();
+  }
+
+  return output;
+}
+
+template <typename MUTATION, typename CROSSOVER, size_t DIM, StreamRng RNG,
+          typename PRECISION>
+template <typename FUN>
+  requires Objective<FUN, PRECISION>
+void DiffEvoEngine<MUTATION, CROSSOVER, DIM, RNG, PRECISION>::Continue(
+    size_t iterations, FUN &fun, ConvergenceWriter &log) {
+  // the log stores double genomes, other gene types are converted here
+  std::vector<double> genome;
+  while (evaluations_ < iterations) {
+    Step(fun);
+    DIFF_EVO_SINK(stats_[0]);
+    {
+      DIFF_EVO_PHASE(kReporting);
+      const auto &population = Population();
+      const auto best = population.Row(population.best);
+      if constexpr (std::same_as<scalar_t, double>) {
+        log.Append(generation_, evaluations_,
+                   population.costs[population.best], best);
+      } else {
+        genome.assign(best.begin(), best.end());
+        log.Append(generation_, evaluations_,
+                   population.costs[population.best], genome);
+      }
+    }
+    Checkpoint();
+  }
+}
+
+template <typename MUTATION, typename CROSSOVER, size_t DIM, StreamRng RNG,
+          typename PRECISION>
+void DiffEvoEngine<MUTATION, CROSSOVER, DIM, RNG, PRECISION>::SetCheckpoint(
+    std::string path, size_t interval) {
+  checkpoint_path_ = std::move(path);
+  checkpoint_interval_ = interval;
+}
+
+template <typename MUTATION, typename CROSSOVER, size_t DIM, StreamRng RNG,
+          typename PRECISION>
+void DiffEvoEngine<MUTATION, CROSSOVER, DIM, RNG, PRECISION>::Save(
+    const std::string &path) const {
+  const auto &population = Population();
+  const auto dim = population.Row(0).size();
+  std::vector<double> state;
+  if constexpr (requires { mutation_.SaveState(state); }) {
+    mutation_.SaveState(state);
+  }
+
+  snapshot_view_t snapshot;
+  snapshot.seed = seed_;
+  snapshot.run = run_;
+  snapshot.size = population.size;
+  snapshot.dim = dim;
+  snapshot.best = population.best;
+  snapshot.generation = generation_;
+  snapshot.evaluations = evaluations_;
+  snapshot.strategy = kStrategyTag;
+  snapshot.gene_bytes = sizeof(scalar_t);
+  snapshot.cost_bytes = sizeof(cost_t);
+  // snapshots hold doubles, float genes and costs go through copies
+  std::vector<double> copies[4];
+  auto as_doubles = [&copies](auto values, size_t k) {
+    if constexpr (std::same_as<typename decltype(values)::value_type,
+                               double>) {
+      return std::span<const double>(values);
+    } else {
+      copies[k].assign(values.begin(), values.end());
+      return std::span<const double>(copies[k]);
+    }
+  };
+  snapshot.min = as_doubles(std::span(limits_.min), 0);
+  snapshot.max = as_doubles(std::span(limits_.max), 1);
+  snapshot.costs = as_doubles(std::span(population.costs), 2);
+  snapshot.weights =
+      as_doubles(std::span(population.Data(), population.size * dim), 3);
+  snapshot.state = state;
+  WriteSnapshot(path, snapshot);
+}
+
+template <typename MUTATION, typename CROSSOVER, size_t DIM, StreamRng RNG,
+          typename PRECISION>
+void DiffEvoEngine<MUTATION, CROSSOVER, DIM, RNG, PRECISION>::Restore(
+    const snapshot_view_t &snapshot) {
+  if (snapshot.size < 4) {
+    throw std::invalid_argument("population needs at least 4 individuals");
+  }
+  if (DIM != std::dynamic_extent && snapshot.dim != DIM) {
+    throw std::invalid_argument(
+        "snapshot size does not match the engine dimension");
+  }
+  if (snapshot.strategy != kStrategyTag) {
+    throw std::invalid_argument(
+        "snapshot was written by an engine of another strategy");
+  }
+  if (snapshot.gene_bytes != sizeof(scalar_t) ||
+      snapshot.cost_bytes != sizeof(cost_t)) {
+    throw std::invalid_argument(
+        "snapshot was written by an engine of another precision");
+  }
+  limits_.min.assign(snapshot.min.begin(), snapshot.min.end());
+  limits_.max.assign(snapshot.max.begin(), snapshot.max.end());
+  Prepare(snapshot.size, snapshot.dim);
+
+  auto &population = buffers_[0];
+  population.Resize(snapshot.size, snapshot.dim);
+  for (size_t j = 0; j < snapshot.size; ++j) {
+    std::ranges::copy(snapshot.weights.subspan(j * snapshot.dim, snapshot.dim),
+                      population.Row(j).begin());
+  }
+  population.costs.assign(snapshot.costs.begin(), snapshot.costs.end());
+  population.best = snapshot.best;
+  buffers_[1] = population;
+
+  current_ = 0;
+  seed_ = snapshot.seed;
+  run_ = snapshot.run;
+  evaluations_ = snapshot.evaluations;
+  generation_ = snapshot.generation;
+  if constexpr (requires { mutation_.LoadState(snapshot.state); }) {
+    mutation_.LoadState(snapshot.state);
+  }
+}
+
+template <typename MUTATION, typename CROSSOVER, size_t DIM, StreamRng RNG,
+          typename PRECISION>
+template <typename TASK>
+void DiffEvoEngine<MUTATION, CROSSOVER, DIM, RNG, PRECISION>::ForEachChunk(
+    size_t count, TASK &&task) {
+  if (runner_) {
+    runner_->ForEachChunk(count, task);
+  } else {
+    task(0, 0, count);
+  }
+}
+
+template <typename MUTATION, typename CROSSOVER, size_t DIM, StreamRng RNG,
+          typename PRECISION>
+void DiffEvoEngine<MUTATION, CROSSOVER, DIM, RNG, PRECISION>::Prepare(
+    size_t size, size_t dim) {
+  const auto workers = runner_ ? runner_->Workers() : 1;
+  stats_.assign(workers, {});
+
+  de_t scratch;
+  scratch.cost = DBL_MAX;
+  scratch.weight.resize(dim);
+  scratch.min_limits.assign(limits_.min.begin(), limits_.min.end());
+  scratch.max_limits.assign(limits_.max.begin(), limits_.max.end());
+  scratch_.assign(workers, scratch);
+  chunk_best_.assign(workers, size);
+  changed_.assign(workers, {});
+  for (auto &changed : changed_) {
+    changed.reserve(dim);
+  }
+  deferred_.assign(workers, {});
+  for (auto &deferred : deferred_) {
+    deferred.Resize(kDeferredGroup, dim);
+  }
+  deferred_rows_.assign(workers, {});
+  for (auto &rows : deferred_rows_) {
+    rows.reserve(kDeferredGroup);
+  }
+  if constexpr (BufferedStreamRng<RNG>) {
+    blocks_ = RNG::BufferedStream::Blocks(dim);
+    words_.assign(workers, std::vector<uint32_t>(kStreamGroup * blocks_ * 4));
+  } else {
+    words_.assign(workers, {});
+  }
+}
+
+template <typename MUTATION, typename CROSSOVER, size_t DIM, StreamRng RNG,
+          typename PRECISION>
+void
+DiffEvoEngine<MUTATION, CROSSOVER, DIM, RNG, PRECISION>::Checkpoint() const {
+  if (checkpoint_interval_ == 0 || checkpoint_path_.empty()) return;
+  if (generation_ % checkpoint_interval_ != 0) return;
+  DIFF_EVO_PHASE(kReporting);
+  Save(checkpoint_path_);
+}
+
+template <typename MUTATION, typename CROSSOVER, size_t DIM, StreamRng RNG,
+          typename PRECISION>
+void DiffEvoEngine<MUTATION, CROSSOVER, DIM, RNG, PRECISION>::Clamp(
+    std::span<scalar_t, DIM> weight) const {
+  DIFF_EVO_COUNT(clamped_genes,
+                 OutOfLimits(std::span<const scalar_t, DIM>(weight),
+                             limits_.min.data(), limits_.max.data()));
+  ClampToLimits(weight, limits_.min.data(), limits_.max.data());
+}
+
+template <typename MUTATION, typename CROSSOVER, size_t DIM, StreamRng RNG,
+          typename PRECISION>
+template <typename DONE>
+void DiffEvoEngine<MUTATION, CROSSOVER, DIM, RNG, PRECISION>::BuildChildren(
+    const population_t &current, population_t &next, size_t begin, size_t end,
+    std::vector<uint32_t> &words, std::vector<size_t> *mutant_genes,
+    DONE &&done) {
+  const auto generation = static_cast<uint32_t>(generation_ + 1);
+  auto build = [&](size_t j, auto &gen) {
+    auto trial = next.Row(j);
+    const auto params = mutation_.Params(j);
+
+    size_t base;
+    {
+      DIFF_EVO_PHASE(kMutation);
+      base = mutation_.Mutate(current, j, params, gen, trial);
+    }
+    {
+      DIFF_EVO_PHASE(kCrossover);
+      if constexpr (kListsMutantGenes) {
+        if (mutant_genes) {
+          crossover_.Cross(trial, current.Row(base), params.cross_rate, gen,
+                           *mutant_genes);
+        } else {
+          crossover_.Cross(trial, current.Row(base), params.cross_rate, gen);
+        }
+      } else {
+        crossover_.Cross(trial, current.Row(base), params.cross_rate, gen);
+      }
+      Clamp(trial);
+    }
+    DIFF_EVO_COUNT(children, 1);
+    done(j, base);
+  };
+
+  if constexpr (BufferedStreamRng<RNG>) {
+    // the head of kStreamGroup streams at a time, in SIMD lanes
+    for (size_t first = begin; first < end; first += kStreamGroup) {
+      const auto count = std::min(kStreamGroup, end - first);
+      RNG::FillStreams(seed_, run_, generation,
+                       static_cast<uint32_t>(first), count, blocks_,
+                       words.data());
+      for (size_t j = first; j < first + count; ++j) {
+        typename RNG::BufferedStream gen(
+            words.data() + (j - first) * blocks_ * 4, blocks_, seed_, run_,
+            generation, static_cast<uint32_t>(j));
+        build(j, gen);
+      }
+    }
+  } else {
+    for (size_t j = begin; j < end; ++j) {
+      RNG gen(seed_, run_, generation, static_cast<uint32_t>(j));
+      build(j, gen);
+    }
+  }
+}
+
+template <typename MUTATION, typename CROSSOVER, size_t DIM, StreamRng RNG,
+          typename PRECISION>
+template <typename FUN>
+size_t DiffEvoEngine<MUTATION, CROSSOVER, DIM, RNG, PRECISION>::EvaluateRows(
+    FUN &fun, population_t &population, size_t begin, size_t end,
+    de_t &scratch) {
+  DIFF_EVO_PHASE(kEvaluation);
+  auto &costs = population.costs;
+  size_t best = begin;
+  if constexpr (BatchObjective<FUN, PRECISION>) {
+    fun(population_view_structure<scalar_t>{population.Row(begin).data(),
+                                            end - begin,
+                                            population.Row(begin).size()},
+        std::span(costs).subspan(begin, end - begin));
+    for (size_t j = begin + 1; j < end; ++j) {
+      if (costs[j] < costs[best]) best = j;
+    }
+  } else {
+    for (size_t j = begin; j < end; ++j) {
+      std::ranges::copy(population.Row(j), scratch.weight.begin());
+      fun(&scratch);
+      costs[j] = static_cast<cost_t>(scratch.cost);
+      if (costs[j] < costs[best]) best = j;
+    }
+  }
+  return best;
+}
+
+template <typename MUTATION, typename CROSSOVER, size_t DIM, StreamRng RNG,
+          typename PRECISION>
+template <typename FUN>
+bool DiffEvoEngine<MUTATION, CROSSOVER, DIM, RNG, PRECISION>::DeltaCost(
+    FUN &fun, const population_t &current, size_t base, population_t &next,
+    size_t j, std::vector<size_t> &changed) {
+  DIFF_EVO_PHASE(kEvaluation);
+  const auto parent = current.Row(base);
+  const auto trial = next.Row(j);
+  if constexpr (kListsMutantGenes) {
+    // only the mutant genes listed by the crossover need a look, some of
+    // them were clamped or drawn back onto the parent's value
+    size_t kept = 0;
+    for (size_t k = 0; k < changed.size(); ++k) {
+      changed[kept] = changed[k];
+      kept += trial[changed[k]] != parent[changed[k]];
+    }
+    changed.resize(kept);
+  } else {
+    changed.clear();
+    for (size_t i = 0; i < trial.size(); ++i) {
+      if (trial[i] != parent[i]) changed.push_back(i);
+    }
+  }
+  // past half of the genes the delta is no cheaper than a full evaluation
+  if (2 * changed.size() > trial.size()) return false;
+  next.costs[j] = fun.Delta(parent, current.costs[base], trial, changed);
+  return true;
+}
+
+template <typename MUTATION, typename CROSSOVER, size_t DIM, StreamRng RNG,
+          typename PRECISION>
+template <typename FUN>
+void DiffEvoEngine<MUTATION, CROSSOVER, DIM, RNG, PRECISION>::Defer(
+    FUN &fun, population_t &next, size_t j, size_t chunk) {
+  auto &rows = deferred_rows_[chunk];
+  std::ranges::copy(next.Row(j), deferred_[chunk].Row(rows.size()).begin());
+  rows.push_back(j);
+  if (rows.size() == kDeferredGroup) EvaluateDeferred(fun, next, chunk);
+}
+
+template <typename MUTATION, typename CROSSOVER, size_t DIM, StreamRng RNG,
+          typename PRECISION>
+template <typename FUN>
+void DiffEvoEngine<MUTATION, CROSSOVER, DIM, RNG, PRECISION>::EvaluateDeferred(
+    FUN &fun, population_t &next, size_t chunk) {
+  auto &rows = deferred_rows_[chunk];
+  if (rows.empty()) return;
+  auto &deferred = deferred_[chunk];
+  EvaluateRows(fun, deferred, 0, rows.size(), scratch_[chunk]);
+  for (size_t k = 0; k < rows.size(); ++k) {
+    next.costs[rows[k]] = deferred.costs[k];
+  }
+  rows.clear();
+}
+
+template <typename MUTATION, typename CROSSOVER, size_t DIM, StreamRng RNG,
+          typename PRECISION>
+size_t DiffEvoEngine<MUTATION, CROSSOVER, DIM, RNG, PRECISION>::BestRow(
+    const population_t &population, size_t begin, size_t end) const {
+  size_t best = begin;
+  for (size_t j = begin + 1; j < end; ++j) {
+    if (population.costs[j] < population.costs[best]) best = j;
+  }
+  return best;
+}
+
+template <typename MUTATION, typename CROSSOVER, size_t DIM, StreamRng RNG,
+          typename PRECISION>
+void DiffEvoEngine<MUTATION, CROSSOVER, DIM, RNG, PRECISION>::MergeBest(
+    population_t &population) {
+  DIFF_EVO_PHASE(kReporting);
+  size_t best = population.size;
+  for (auto &candidate : chunk_best_) {
+    // indices past the end were left by a population that since shrank
+    if (candidate < population.size &&
+        (best == population.size ||
+         population.costs[candidate] < population.costs[best])) {
+      best = candidate;
+    }
+    candidate = population.size;
+  }
+  population.best = best;
+}
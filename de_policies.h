@@ -0,0 +1,607 @@
+/*
+ * Created by kureii on 11/15/24.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <numeric>
+#include <random>
+#include <span>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "instrumentation.h"
+
+// Mutation and crossover policies plugged into DiffEvoEngine.
+//
+// A mutation policy provides
+//   void BeginGeneration(GEN &gen, size_t size);
+//   de_params_t Params(size_t child) const;
+//   size_t Mutate(const POP &population, size_t child,
+//                 const de_params_t &params, GEN &gen,
+//                 std::span<SCALAR, DIM> trial) const;
+// BeginGeneration runs on a single thread before the generation is built,
+// Params and Mutate may run concurrently for different children. Mutate
+// writes the mutant for `child`, which replaces population.Row(child), into
+// `trial` and returns the index of the individual the crossover takes the
+// remaining genes from.
+//
+// A policy that needs the population itself may take it in place of the
+// size, void BeginGeneration(GEN &gen, const POP &population), and may also
+// provide
+//   void EndGeneration(GEN &gen, const POP &parents, POP &children,
+//                      size_t evaluations);
+// which DiffEvoEngine calls on a single thread once the children are
+// evaluated. `children` becomes the next population: the policy may put
+// parents back in place of worse children and shrink it to fewer rows.
+// `evaluations` includes the children just evaluated.
+//
+// Policies that adapt parameters during a run may also provide
+//   void SaveState(std::vector<double> &state) const;
+//   void LoadState(std::span<const double> state);
+// so the adapted values survive a snapshot (see snapshot.h). LoadState
+// throws std::invalid_argument for a state it did not save. A mutation
+// policy may name its strategy in snapshots with
+//   static constexpr uint32_t kSnapshotTag;
+// which Restore compares, policies without one are written as 0.
+//
+// A crossover policy provides
+//   void Cross(std::span<SCALAR, DIM> trial, std::span<const SCALAR, DIM> base,
+//              double cross_rate, GEN &gen) const;
+// and may provide an overload with a trailing std::vector<size_t> &, filled
+// with the ascending indices of the genes kept from the mutant. DiffEvoEngine
+// then takes the changed genes of a DeltaObjective from it instead of
+// comparing every child with its base.
+//
+// GEN is any uniform random bit generator, the engine hands every child its
+// own stream (see philox.h). SCALAR is the gene type of the population, the
+// arithmetic on genes stays in it.
+
+// Mutation factor and crossover rate used for one child.
+struct de_params_structure {
+  double mutation_rate;
+  double cross_rate;
+};
+
+using de_params_t = de_params_structure;
+
+// Calls fn(i) for every gene. Small compile time dimensions are fully
+// unrolled, everything else is a plain loop.
+template <size_t EXTENT, typename FN>
+inline void ForEachGene(size_t dim, FN &&fn) {
+  if constexpr (EXTENT != std::dynamic_extent && EXTENT <= 32) {
+    [&]<size_t... I>(std::index_sequence<I...>) {
+      (fn(I), ...);
+    }(std::make_index_sequence<EXTENT>{});
+  } else {
+    for (size_t i = 0; i < dim; ++i) {
+      fn(i);
+    }
+  }
+}
+
+// Clamps every gene into [min[i], max[i]].
+template <typename SCALAR, size_t DIM>
+inline void ClampToLimits(std::span<SCALAR, DIM> weight, const SCALAR *min,
+                          const SCALAR *max) {
+  ForEachGene<DIM>(weight.size(), [&](size_t i) {
+    if (weight[i] < min[i]) {
+      weight[i] = min[i];
+    }
+    if (weight[i] > max[i]) {
+      weight[i] = max[i];
+    }
+  });
+}
+
+// Number of genes outside of [min[i], max[i]].
+template <typename SCALAR, size_t DIM>
+inline size_t OutOfLimits(std::span<const SCALAR, DIM> weight,
+                          const SCALAR *min, const SCALAR *max) {
+  size_t count = 0;
+  ForEachGene<DIM>(weight.size(), [&](size_t i) {
+    count += weight[i] < min[i] || weight[i] > max[i];
+  });
+  return count;
+}
+
+// Generator that also hands out a run of raw 32 bit words in one piece,
+// letting per-gene decisions be made without a call per gene.
+template <typename GEN>
+concept BulkGenerator = requires(const GEN &gen, size_t n) {
+  { gen.Bulk(n) } -> std::convertible_to<std::span<const uint32_t>>;
+};
+
+// Uniform index in [0, size). 32 bit generators use Lemire's multiply and
+// shift with rejection, which is unbiased and needs no division in the
+// common case.
+template <typename GEN>
+inline size_t UniformIndex(GEN &gen, size_t size) {
+  if constexpr (GEN::min() == 0 &&
+                GEN::max() == std::numeric_limits<uint32_t>::max()) {
+    const auto range = static_cast<uint32_t>(size);
+    auto product = static_cast<uint64_t>(static_cast<uint32_t>(gen())) * range;
+    if (static_cast<uint32_t>(product) < range) {
+      const uint32_t threshold = -range % range;
+      while (static_cast<uint32_t>(product) < threshold) {
+        product = static_cast<uint64_t>(static_cast<uint32_t>(gen())) * range;
+      }
+    }
+    return static_cast<size_t>(product >> 32);
+  } else {
+    return std::uniform_int_distribution<size_t>(0, size - 1)(gen);
+  }
+}
+
+// Fills `donors` with distinct indices from [0, size) that also differ from
+// `exclude`, pass `size` to exclude nothing.
+template <typename GEN>
+inline void PickDonors(GEN &gen, size_t size, size_t exclude,
+                       std::span<size_t> donors) {
+  DIFF_EVO_PHASE(kDonors);
+  for (size_t k = 0; k < donors.size(); ++k) {
+    size_t candidate;
+    do {
+      candidate = UniformIndex(gen, size);
+    } while (candidate == exclude ||
+             std::ranges::find(donors.first(k), candidate) !=
+                 donors.first(k).end());
+    donors[k] = candidate;
+  }
+}
+
+// v = x1 + F * (x2 - x3)
+struct Rand1Mutation {
+  static constexpr uint32_t kSnapshotTag = 1;
+  de_params_t params;
+
+  template <typename GEN>
+  void BeginGeneration(GEN &, size_t) {}
+  [[nodiscard]] de_params_t Params(size_t) const { return params; }
+
+  template <typename POP, typename SCALAR, size_t DIM, typename GEN>
+  size_t Mutate(const POP &population, size_t, const de_params_t &p, GEN &gen,
+                std::span<SCALAR, DIM> trial) const {
+    size_t donors[3];
+    PickDonors(gen, population.size, population.size, donors);
+
+    const auto f = static_cast<SCALAR>(p.mutation_rate);
+    const auto x1 = population.Row(donors[0]);
+    const auto x2 = population.Row(donors[1]);
+    const auto x3 = population.Row(donors[2]);
+    ForEachGene<DIM>(trial.size(), [&](size_t i) {
+      trial[i] = x1[i] + f * (x2[i] - x3[i]);
+    });
+    return donors[0];
+  }
+};
+
+// v = best + F * (x2 - x3)
+struct Best1Mutation {
+  static constexpr uint32_t kSnapshotTag = 2;
+  de_params_t params;
+
+  template <typename GEN>
+  void BeginGeneration(GEN &, size_t) {}
+  [[nodiscard]] de_params_t Params(size_t) const { return params; }
+
+  template <typename POP, typename SCALAR, size_t DIM, typename GEN>
+  size_t Mutate(const POP &population, size_t, const de_params_t &p, GEN &gen,
+                std::span<SCALAR, DIM> trial) const {
+    size_t donors[2];
+    PickDonors(gen, population.size, population.best, donors);
+
+    const auto f = static_cast<SCALAR>(p.mutation_rate);
+    const auto best = population.Row(population.best);
+    const auto x2 = population.Row(donors[0]);
+    const auto x3 = population.Row(donors[1]);
+    ForEachGene<DIM>(trial.size(), [&](size_t i) {
+      trial[i] = best[i] + f * (x2[i] - x3[i]);
+    });
+    return population.best;
+  }
+};
+
+// rand/1 whose F and CR are redrawn with probability tau2 and tau1. The
+// parameters drift from child to child, so they are drawn for the whole
+// generation up front.
+struct JdeMutation {
+  static constexpr uint32_t kSnapshotTag = 3;
+  de_params_t params;
+  double tau1;
+  double tau2;
+  std::vector<de_params_t> child_params;
+
+  template <typename GEN>
+  void BeginGeneration(GEN &gen, size_t size) {
+    std::uniform_real_distribution<> uniform(0.0, 1.0);
+    std::uniform_real_distribution<> f_dist(0.1, 0.9);
+
+    child_params.resize(size);
+    for (auto &child : child_params) {
+      if (uniform(gen) < tau1) {
+        params.cross_rate = uniform(gen);
+      }
+      if (uniform(gen) < tau2) {
+        params.mutation_rate = f_dist(gen);
+      }
+      child = params;
+    }
+  }
+  [[nodiscard]] de_params_t Params(size_t child) const {
+    return child_params[child];
+  }
+
+  void SaveState(std::vector<double> &state) const {
+    state = {params.mutation_rate, params.cross_rate};
+  }
+  void LoadState(std::span<const double> state) {
+    if (state.size() != 2) {
+      throw std::invalid_argument("snapshot state is not that of jDE");
+    }
+    params = {state[0], state[1]};
+  }
+
+  template <typename POP, typename SCALAR, size_t DIM, typename GEN>
+  size_t Mutate(const POP &population, size_t child, const de_params_t &p,
+                GEN &gen, std::span<SCALAR, DIM> trial) const {
+    return Rand1Mutation{p}.Mutate(population, child, p, gen, trial);
+  }
+};
+
+// L-SHADE (Tanabe and Fukunaga, 2014): current-to-pbest/1 with an external
+// archive,
+//   v = x + F * (x_pbest - x) + F * (x1 - x2),  x2 from population + archive
+// F and CR drawn around a history of the values that produced improvements,
+// and a population that shrinks linearly from its initial size to
+// `min_size` over `max_evaluations`. Children only replace parents they do
+// not make worse, improved parents go to the archive. Meant for a
+// BinomialCrossover that forces a mutant gene, a CR memory that drops to 0
+// would otherwise produce copies of the parents.
+struct LshadeMutation {
+  static constexpr uint32_t kSnapshotTag = 4;
+  // budget the population shrinks over, normally that of the whole run
+  size_t max_evaluations;
+  size_t min_size = 4;
+  size_t memory_size = 6;
+  // archive capacity relative to the population size
+  double archive_rate = 2.6;
+  // x_pbest is drawn from the best p_best * size individuals
+  double p_best = 0.11;
+
+  // success history, kMemoryEmpty marks a CR entry that stays 0
+  static constexpr double kMemoryEmpty = -1.0;
+  std::vector<double> memory_f{};
+  std::vector<double> memory_cr{};
+  size_t memory_next = 0;
+  size_t initial_size = 0;
+  // row major, archive_size rows of dim genes
+  size_t dim = 0;
+  size_t archive_size = 0;
+  std::vector<double> archive{};
+  std::vector<de_params_t> child_params{};
+  // the population by rising cost, p-best donors are its first `top`
+  std::vector<size_t> order{};
+  size_t top = 0;
+  std::vector<double> success_f{};
+  std::vector<double> success_cr{};
+  std::vector<double> success_weight{};
+  std::vector<char> keep{};
+
+  template <typename GEN, typename POP>
+  void BeginGeneration(GEN &gen, const POP &population) {
+    const auto size = population.size;
+    if (memory_f.empty()) {
+      memory_f.assign(memory_size, 0.5);
+      memory_cr.assign(memory_size, 0.5);
+      initial_size = size;
+    }
+    if (dim == 0) dim = population.Row(0).size();
+
+    top = std::clamp<size_t>(
+        static_cast<size_t>(std::lround(p_best * static_cast<double>(size))),
+        2, size);
+    order.resize(size);
+    std::iota(order.begin(), order.end(), size_t{0});
+    std::partial_sort(order.begin(), order.begin() + top, order.end(),
+                      [&](size_t a, size_t b) {
+                        return population.costs[a] < population.costs[b];
+                      });
+
+    child_params.resize(size);
+    for (auto &child : child_params) {
+      const auto r = UniformIndex(gen, memory_f.size());
+      child.cross_rate =
+          memory_cr[r] == kMemoryEmpty
+              ? 0.0
+              : std::clamp(
+                    std::normal_distribution<>(memory_cr[r], 0.1)(gen), 0.0,
+                    1.0);
+      std::cauchy_distribution<> cauchy(memory_f[r], 0.1);
+      do {
+        child.mutation_rate = cauchy(gen);
+      } while (!(child.mutation_rate > 0.0));
+      child.mutation_rate = std::min(child.mutation_rate, 1.0);
+    }
+  }
+  [[nodiscard]] de_params_t Params(size_t child) const {
+    return child_params[child];
+  }
+
+  template <typename POP, typename SCALAR, size_t DIM, typename GEN>
+  size_t Mutate(const POP &population, size_t child, const de_params_t &p,
+                GEN &gen, std::span<SCALAR, DIM> trial) const {
+    const auto pbest = population.Row(order[UniformIndex(gen, top)]);
+    size_t r1;
+    PickDonors(gen, population.size, child, std::span(&r1, 1));
+    size_t r2;
+    do {
+      r2 = UniformIndex(gen, population.size + archive_size);
+    } while (r2 == child || r2 == r1);
+
+    const auto f = static_cast<SCALAR>(p.mutation_rate);
+    const auto x = population.Row(child);
+    const auto x1 = population.Row(r1);
+    auto combine = [&](auto x2) {
+      ForEachGene<DIM>(trial.size(), [&](size_t i) {
+        trial[i] = x[i] + f * (pbest[i] - x[i]) +
+                   f * (x1[i] - static_cast<SCALAR>(x2[i]));
+      });
+    };
+    if (r2 < population.size) {
+      combine(population.Row(r2));
+    } else {
+      combine(archive.data() + (r2 - population.size) * dim);
+    }
+    return child;
+  }
+
+  template <typename GEN, typename POP>
+  void EndGeneration(GEN &gen, const POP &parents, POP &children,
+                     size_t evaluations) {
+    const auto size = parents.size;
+    success_f.clear();
+    success_cr.clear();
+    success_weight.clear();
+    for (size_t j = 0; j < size; ++j) {
+      const double parent_cost = parents.costs[j];
+      const double child_cost = children.costs[j];
+      if (child_cost < parent_cost) {
+        success_f.push_back(child_params[j].mutation_rate);
+        success_cr.push_back(child_params[j].cross_rate);
+        success_weight.push_back(parent_cost - child_cost);
+        Archive(gen, parents.Row(j), ArchiveCapacity(size));
+      } else if (!(child_cost <= parent_cost)) {
+        std::ranges::copy(parents.Row(j), children.Row(j).begin());
+        children.costs[j] = parents.costs[j];
+      }
+    }
+    UpdateMemory();
+
+    // linear population size reduction, the worst individuals leave
+    const auto floor = std::max<size_t>(min_size, 4);
+    const auto planned = std::lround(
+        static_cast<double>(initial_size) -
+        static_cast<double>(initial_size - std::min(floor, initial_size)) *
+            static_cast<double>(std::min(evaluations, max_evaluations)) /
+            static_cast<double>(max_evaluations));
+    const auto next_size =
+        std::clamp<size_t>(static_cast<size_t>(planned), floor, size);
+    if (next_size < size) Shrink(children, next_size);
+
+    const auto capacity = ArchiveCapacity(children.size);
+    while (archive_size > capacity) {
+      const auto victim = UniformIndex(gen, archive_size);
+      --archive_size;
+      if (victim != archive_size) {
+        std::copy_n(archive.begin() + archive_size * dim, dim,
+                    archive.begin() + victim * dim);
+      }
+    }
+  }
+
+  void SaveState(std::vector<double> &state) const {
+    state = {static_cast<double>(memory_f.size()),
+             static_cast<double>(memory_next),
+             static_cast<double>(initial_size), static_cast<double>(dim),
+             static_cast<double>(archive_size)};
+    state.insert(state.end(), memory_f.begin(), memory_f.end());
+    state.insert(state.end(), memory_cr.begin(), memory_cr.end());
+    state.insert(state.end(), archive.begin(),
+                 archive.begin() + archive_size * dim);
+  }
+  void LoadState(std::span<const double> state) {
+    // counts are checked before they are cast or multiplied
+    auto count = [&state](size_t k) {
+      if (!(state[k] >= 0.0 && state[k] <= 0x1p53) ||
+          state[k] != std::floor(state[k])) {
+        throw std::invalid_argument("snapshot state is not that of L-SHADE");
+      }
+      return static_cast<size_t>(state[k]);
+    };
+    if (state.size() < 5) {
+      throw std::invalid_argument("snapshot state is not that of L-SHADE");
+    }
+    const auto memory = count(0);
+    const auto next = count(1);
+    const auto genes = count(3);
+    const auto rows = count(4);
+    const auto stored = state.size() - 5;
+    // a snapshot taken before the first generation has no memory yet
+    if ((memory == 0 ? next != 0 : next >= memory) || memory > stored / 2 ||
+        (genes != 0 && rows > stored / genes) ||
+        stored != 2 * memory + rows * genes) {
+      throw std::invalid_argument("snapshot state is not that of L-SHADE");
+    }
+
+    memory_next = next;
+    initial_size = count(2);
+    dim = genes;
+    archive_size = rows;
+    const auto values = state.subspan(5);
+    memory_f.assign(values.begin(), values.begin() + memory);
+    memory_cr.assign(values.begin() + memory, values.begin() + 2 * memory);
+    archive.assign(values.begin() + 2 * memory, values.end());
+  }
+
+ private:
+  [[nodiscard]] size_t ArchiveCapacity(size_t size) const {
+    return static_cast<size_t>(
+        std::lround(archive_rate * static_cast<double>(size)));
+  }
+
+  // Adds `parent` to the archive, replacing a random member once full.
+  template <typename GEN, typename ROW>
+  void Archive(GEN &gen, ROW parent, size_t capacity) {
+    if (capacity == 0) return;
+    auto row = archive_size;
+    if (archive_size < capacity) {
+      ++archive_size;
+      if (archive.size() < archive_size * dim) {
+        archive.resize(capacity * dim);
+      }
+    } else {
+      row = UniformIndex(gen, archive_size);
+    }
+    std::ranges::copy(parent, archive.begin() + row * dim);
+  }
+
+  // Weighted Lehmer means of the successful F and CR, weighted by how much
+  // they improved on their parents.
+  void UpdateMemory() {
+    if (success_f.empty()) return;
+    double total = 0;
+    for (const auto weight : success_weight) {
+      total += weight;
+    }
+    if (!(total > 0)) return;
+
+    double f_squares = 0, f_sum = 0, cr_squares = 0, cr_sum = 0;
+    double cr_max = 0;
+    for (size_t k = 0; k < success_f.size(); ++k) {
+      const auto weight = success_weight[k] / total;
+      f_squares += weight * success_f[k] * success_f[k];
+      f_sum += weight * success_f[k];
+      cr_squares += weight * success_cr[k] * success_cr[k];
+      cr_sum += weight * success_cr[k];
+      cr_max = std::max(cr_max, success_cr[k]);
+    }
+    memory_f[memory_next] = f_squares / f_sum;
+    memory_cr[memory_next] =
+        memory_cr[memory_next] == kMemoryEmpty || cr_max == 0
+            ? kMemoryEmpty
+            : cr_squares / cr_sum;
+    memory_next = (memory_next + 1) % memory_f.size();
+  }
+
+  // Drops the worst rows, the rest move into rows [0, next_size) without
+  // touching the capacity of the population.
+  template <typename POP>
+  void Shrink(POP &population, size_t next_size) {
+    const auto size = population.size;
+    order.resize(size);
+    std::iota(order.begin(), order.end(), size_t{0});
+    std::nth_element(order.begin(), order.begin() + next_size, order.end(),
+                     [&](size_t a, size_t b) {
+                       return population.costs[a] < population.costs[b];
+                     });
+    keep.assign(size, 0);
+    for (size_t k = 0; k < next_size; ++k) {
+      keep[order[k]] = 1;
+    }
+
+    auto from = next_size;
+    for (size_t j = 0; j < next_size; ++j) {
+      if (keep[j]) continue;
+      while (!keep[from]) ++from;
+      std::ranges::copy(population.Row(from), population.Row(j).begin());
+      population.costs[j] = population.costs[from];
+      ++from;
+    }
+    population.Resize(next_size, dim);
+  }
+};
+
+// Takes each gene from `base` with probability 1 - CR. Bulk generators
+// compare raw words against CR scaled to 2^32 instead of drawing a double
+// per gene, a branch free loop the compiler turns into vector compares and
+// blends. With `force_mutant_gene` one gene drawn at random always stays
+// from the mutant, so a trial never copies its base even at CR 0. The
+// classic strategies leave it off and keep their results, L-SHADE needs it.
+struct BinomialCrossover {
+  bool force_mutant_gene = false;
+
+  template <typename SCALAR, size_t DIM, typename GEN>
+  void Cross(std::span<SCALAR, DIM> trial, std::span<const SCALAR, DIM> base,
+             double cross_rate, GEN &gen) const {
+    CrossGenes(trial, base, cross_rate, gen, nullptr);
+  }
+  // Same trial, and also lists the genes kept from the mutant in ascending
+  // order into `mutant_genes`, for DeltaObjective.
+  template <typename SCALAR, size_t DIM, typename GEN>
+  void Cross(std::span<SCALAR, DIM> trial, std::span<const SCALAR, DIM> base,
+             double cross_rate, GEN &gen,
+             std::vector<size_t> &mutant_genes) const {
+    CrossGenes(trial, base, cross_rate, gen, &mutant_genes);
+  }
+
+ private:
+  template <typename SCALAR, size_t DIM, typename GEN>
+  void CrossGenes(std::span<SCALAR, DIM> trial,
+                  std::span<const SCALAR, DIM> base, double cross_rate,
+                  GEN &gen, std::vector<size_t> *mutant_genes) const {
+    if (mutant_genes) mutant_genes->clear();
+    if constexpr (BulkGenerator<GEN>) {
+      const auto words = gen.Bulk(trial.size());
+      if (cross_rate >= 1.0) {
+        if (mutant_genes) {
+          mutant_genes->resize(trial.size());
+          std::iota(mutant_genes->begin(), mutant_genes->end(), size_t{0});
+        }
+        return;
+      }
+      const auto forced = ForcedGene(trial.size(), gen);
+      const auto kept = forced < trial.size() ? trial[forced] : SCALAR{};
+      const auto threshold =
+          cross_rate > 0.0 ? static_cast<uint32_t>(cross_rate * 0x1p32) : 0;
+      ForEachGene<DIM>(trial.size(), [&](size_t i) {
+        trial[i] = words[i] < threshold ? trial[i] : base[i];
+      });
+      if (forced < trial.size()) trial[forced] = kept;
+      // listed in a pass of its own, both loops stay free of branches
+      if (mutant_genes) {
+        mutant_genes->resize(trial.size());
+        size_t count = 0;
+        for (size_t i = 0; i < trial.size(); ++i) {
+          (*mutant_genes)[count] = i;
+          count += words[i] < threshold || i == forced;
+        }
+        mutant_genes->resize(count);
+      }
+    } else {
+      const auto forced = ForcedGene(trial.size(), gen);
+      std::uniform_real_distribution<> uniform(0.0, 1.0);
+      ForEachGene<DIM>(trial.size(), [&](size_t i) {
+        if (uniform(gen) > cross_rate && i != forced) {
+          trial[i] = base[i];
+        } else if (mutant_genes) {
+          mutant_genes->push_back(i);
+        }
+      });
+    }
+  }
+
+  // index of the gene kept from the mutant, `dim` (none) unless forced
+  template <typename GEN>
+  size_t ForcedGene(size_t dim, GEN &gen) const {
+    if (!force_mutant_gene) return dim;
+    return std::uniform_int_distribution<size_t>(0, dim - 1)(gen);
+  }
+};
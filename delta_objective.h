@@ -0,0 +1,76 @@
+/*
+ * Created by kureii on 11/15/24.
+ */
+
+#pragma once
+
+#include <concepts>
+#include <cstddef>
+#include <span>
+
+#include "structures.h"
+
+// Objective that can derive the cost of `trial` from the known cost of
+// `base` when only the genes listed in `changed` (ascending) differ:
+//
+//   double Delta(std::span<const double> base, double base_cost,
+//                std::span<const double> trial,
+//                std::span<const size_t> changed) const;
+//
+// DiffEvoEngine uses it for every child whose crossover kept most genes of
+// its base, the cost then follows from the changed genes alone. Incremental
+// costs collect rounding error, so the engine still evaluates everything in
+// full every few generations. Genes and costs have the types of PRECISION.
+template <typename FUN, typename PRECISION = double_precision_t>
+concept DeltaObjective =
+    requires(const FUN &fun,
+             std::span<const typename PRECISION::scalar_type> weight,
+             typename PRECISION::cost_type cost,
+             std::span<const size_t> changed) {
+      {
+        fun.Delta(weight, cost, weight, changed)
+      } -> std::convertible_to<typename PRECISION::cost_type>;
+    };
+
+// f(x) = sum_i TERM(x_i), evaluated in full by the batched BATCH.
+template <auto BATCH, auto TERM>
+struct SeparableObjective {
+  void operator()(pop_view_t population, std::span<double> costs) const {
+    BATCH(population, costs);
+  }
+
+  [[nodiscard]] double Delta(std::span<const double> base, double base_cost,
+                             std::span<const double> trial,
+                             std::span<const size_t> changed) const {
+    auto cost = base_cost;
+    for (const auto i : changed) {
+      cost += TERM(trial[i]) - TERM(base[i]);
+    }
+    return cost;
+  }
+};
+
+// f(x) = sum_i TERM(x_i, x_{i+1}), each gene couples to its neighbours only,
+// so a changed gene i touches terms i - 1 and i.
+template <auto BATCH, auto TERM>
+struct ChainedObjective {
+  void operator()(pop_view_t population, std::span<double> costs) const {
+    BATCH(population, costs);
+  }
+
+  [[nodiscard]] double Delta(std::span<const double> base, double base_cost,
+                             std::span<const double> trial,
+                             std::span<const size_t> changed) const {
+    const auto terms = trial.size() - 1;
+    auto cost = base_cost;
+    size_t next_term = 0;
+    for (const auto i : changed) {
+      for (auto k = i > 0 ? i - 1 : 0; k <= i && k < terms; ++k) {
+        if (k < next_term) continue;
+        cost += TERM(trial[k], trial[k + 1]) - TERM(base[k], base[k + 1]);
+        next_term = k + 1;
+      }
+    }
+    return cost;
+  }
+};
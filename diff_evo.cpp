@@ -7,115 +7,174 @@
 #include <algorithm>
 #include <cfloat>
 #include <stdexcept>
+#include <utility>
 
 DiffEvo::DiffEvo() : gen_(rd_()), distrib_(0.0, 1.0) {}
 
-const std::vector<de_t> &DiffEvo::GetInitPopulation() const {
+DiffEvo::DiffEvo(uint64_t seed) : distrib_(0.0, 1.0) {
+  std::seed_seq seq{static_cast<uint32_t>(seed),
+                    static_cast<uint32_t>(seed >> 32)};
+  gen_.seed(seq);
+}
+
+const pop_t &DiffEvo::GetInitPopulation() const {
   return initial_population_;
 }
 
+const limits_t &DiffEvo::GetLimits() const { return limits_; }
+
 void DiffEvo::GenerateInitPopulation(size_t dimensions, size_t populationSize) {
-  std::vector<de_t> population(populationSize);
-  std::ranges::for_each(population, [&dimensions, this](auto &v) {
-    de_t des;
-    des.cost = DBL_MAX;
-    des.weight.resize(dimensions);
-    for (size_t i = 0; i < dimensions; ++i) {
-      des.weight[i] = distrib_(gen_);
+  initial_population_.Resize(populationSize, dimensions);
+  std::ranges::for_each(initial_population_.weights,
+                        [this](double &v) { v = distrib_(gen_); });
+  std::ranges::fill(initial_population_.costs, DBL_MAX);
+  limits_ = {};
+}
+
+void DiffEvo::SetInitPopulation(const std::vector<de_t> &initial_population) {
+  pop_t population;
+  population.Resize(initial_population.size(),
+                    initial_population.empty()
+                        ? 0
+                        : initial_population[0].weight.size());
+
+  for (size_t i = 0; i < initial_population.size(); ++i) {
+    if (initial_population[i].weight.size() != population.dim) {
+      throw std::invalid_argument(
+          "all individuals of initial_population must have the same size");
     }
-    v = des;
-  });
-  initial_population_ = population;
+    std::ranges::copy(initial_population[i].weight,
+                      population.Row(i).begin());
+    population.costs[i] = initial_population[i].cost;
+  }
+
+  initial_population_ = std::move(population);
+  limits_ = {};
+  if (!initial_population.empty()) {
+    limits_.min = initial_population[0].min_limits;
+    limits_.max = initial_population[0].max_limits;
+  }
 }
 
-void DiffEvo::SetInitPopulation(std::vector<de_t> initial_population) {
+void DiffEvo::SetInitPopulation(pop_t initial_population) {
+  if (initial_population.weights.size() !=
+          initial_population.size * initial_population.dim ||
+      initial_population.costs.size() != initial_population.size) {
+    throw std::invalid_argument(
+        "initial_population weights and costs do not match its size");
+  }
   initial_population_ = std::move(initial_population);
+  limits_ = {};
 }
 
 void DiffEvo::AddMinLimits(const std::vector<double> &min_limits) {
   if (min_limits.empty()) {
     throw std::invalid_argument("min_limits cannot be empty");
   }
-  if (initial_population_.empty()) {
+  if (initial_population_.size == 0) {
     throw std::invalid_argument(
         R"(initial_population must be initialized, use "DiffEvo::GenerateInitPopulation" or "DiffEvo::SetInitPopulation")");
   }
-  if (min_limits.size() != initial_population_[0].weight.size()) {
+  if (min_limits.size() != initial_population_.dim) {
     throw std::invalid_argument(
         "initial_population size does not match min_limits");
   }
 
-  std::ranges::for_each(initial_population_,
-                        [&min_limits](auto &v) { v.min_limits = min_limits; });
+  limits_.min = min_limits;
 }
 
 void DiffEvo::AddMinLimits(double min_limits) {
-  if (initial_population_.empty()) {
+  if (initial_population_.size == 0) {
     throw std::invalid_argument(
         R"(initial_population must be initialized, use "DiffEvo::GenerateInitPopulation" or "DiffEvo::SetInitPopulation")");
   }
 
-  std::ranges::for_each(initial_population_, [&min_limits](auto &individual) {
-    individual.min_limits.resize(individual.weight.size());
-    std::ranges::for_each(individual.min_limits,
-                          [&min_limits](double &value) { value = min_limits; });
-  });
+  limits_.min.assign(initial_population_.dim, min_limits);
 }
 
 void DiffEvo::AddMaxLimits(const std::vector<double> &max_limits) {
   if (max_limits.empty()) {
     throw std::invalid_argument("max_limits cannot be empty");
   }
-  if (initial_population_.empty()) {
+  if (initial_population_.size == 0) {
     throw std::invalid_argument(
         R"(initial_population must be initialized, use "DiffEvo::GenerateInitPopulation" or "DiffEvo::SetInitPopulation")");
   }
-  if (max_limits.size() != initial_population_[0].weight.size()) {
+  if (max_limits.size() != initial_population_.dim) {
     throw std::invalid_argument(
         "initial_population weight size does not match max_limits");
   }
 
-  std::ranges::for_each(initial_population_,
-                        [&max_limits](auto &v) { v.max_limits = max_limits; });
+  limits_.max = max_limits;
 }
 
 void DiffEvo::AddMaxLimits(double max_limits) {
-  if (initial_population_.empty()) {
+  if (initial_population_.size == 0) {
     throw std::invalid_argument(
         R"(initial_population must be initialized, use "DiffEvo::GenerateInitPopulation" or "DiffEvo::SetInitPopulation")");
   }
 
-  std::ranges::for_each(initial_population_, [&max_limits](auto &individual) {
-    individual.max_limits.resize(individual.weight.size());
+  limits_.max.assign(initial_population_.dim, max_limits);
+}
 
-    std::ranges::for_each(individual.max_limits,
-                          [&max_limits](double &value) { value = max_limits; });
-  });
+void DiffEvo::SetThreads(size_t threads) { runner_.SetThreads(threads); }
+
+void DiffEvo::SetExecutor(executor_t executor, size_t tasks) {
+  runner_.SetExecutor(std::move(executor), tasks);
 }
 
+void DiffEvo::SetIslands(island_config_t config) {
+  if (config.islands == 0 || config.migration_interval == 0) {
+    throw std::invalid_argument(
+        "islands and migration_interval must be greater than 0");
+  }
+  islands_ = config;
+}
+
+void DiffEvo::SetConvergenceLog(ConvergenceWriter *log) { log_ = log; }
+
+void DiffEvo::SetCheckpoint(std::string path, size_t interval) {
+  checkpoint_path_ = std::move(path);
+  checkpoint_interval_ = interval;
+}
+
+void DiffEvo::ResumeFrom(std::string path) { resume_path_ = std::move(path); }
+
+const instrumentation_t &DiffEvo::GetInstrumentation() const {
+  return instrumentation_;
+}
+
+void DiffEvo::ResetInstrumentation() { instrumentation_ = {}; }
+
+size_t DiffEvo::GetEvaluations() const { return evaluations_; }
+
 bool DiffEvo::OptimizeInitTest(std::string &err) {
-  if (initial_population_.empty()) {
+  if (initial_population_.size == 0) {
     err =
         R"(initial_population must be initialized, use "DiffEvo::GenerateInitPopulation" or "DiffEvo::SetInitPopulation")";
     return false;
   }
 
-  if (initial_population_[0].min_limits.empty()) {
+  if (limits_.min.empty()) {
     err = R"(min_limits are empty, use "DiffEvo::AddMinLimits")";
     return false;
   }
 
-  if (initial_population_[0].max_limits.empty()) {
+  if (limits_.max.empty()) {
     err = R"(max_limits are empty, use "DiffEvo::AddMaxLimits")";
     return false;
   }
 
-  for (size_t i = 0; i < initial_population_[0].min_limits.size(); ++i) {
-    if (initial_population_[0].min_limits[i] >
-        initial_population_[0].max_limits[i]) {
+  if (limits_.min.size() != initial_population_.dim ||
+      limits_.max.size() != initial_population_.dim) {
+    err = "limits size does not match initial_population weight size";
+    return false;
+  }
+
+  for (size_t i = 0; i < limits_.min.size(); ++i) {
+    if (limits_.min[i] > limits_.max[i]) {
       err = std::format("Limit on index {} is incorrect, {} !< {}", i,
-                        initial_population_[0].min_limits[i],
-                        initial_population_[0].max_limits[i]);
+                        limits_.min[i], limits_.max[i]);
       return false;
     }
   }
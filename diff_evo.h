@@ -4,47 +4,127 @@
 
 #pragma once
 
+#include <cstdint>
 #include <random>
+#include <span>
+#include <string>
 #include <vector>
 
+#include "ask_tell.h"
+#include "convergence_log.h"
+#include "de_engine.h"
+#include "instrumentation.h"
+#include "island_model.h"
+#include "parallel_runner.h"
 #include "structures.h"
 
 class DiffEvo {
  public:
   DiffEvo();
+  // Reproducible instance, every population and run is derived from `seed`.
+  explicit DiffEvo(uint64_t seed);
 
   void GenerateInitPopulation(size_t dimensions, size_t populationSize);
 
-  void SetInitPopulation(std::vector<de_t> initial_population);
-  [[nodiscard]] const std::vector<de_t>& GetInitPopulation() const;
+  void SetInitPopulation(const std::vector<de_t>& initial_population);
+  void SetInitPopulation(pop_t initial_population);
+  [[nodiscard]] const pop_t& GetInitPopulation() const;
+  [[nodiscard]] const limits_t& GetLimits() const;
 
   void AddMinLimits(const std::vector<double>& min_limits);
   void AddMinLimits(double min_limits);
   void AddMaxLimits(const std::vector<double>& max_limits);
   void AddMaxLimits(double max_limits);
 
+  // Builds and evaluates each generation on the given number of threads,
+  // 0 or 1 keeps everything on the calling thread. The objective must be
+  // thread safe once more than one thread is used.
+  void SetThreads(size_t threads);
+  // Same as SetThreads, but every generation is split into `tasks` parts that
+  // are handed to a user supplied executor.
+  void SetExecutor(executor_t executor, size_t tasks);
+  // With more than one island every strategy runs as an IslandModel, one
+  // thread per island, and the thread settings above are not used.
+  void SetIslands(island_config_t config);
+
+  // While set, strategies append every generation to `log` and return an
+  // empty history. The log has to outlive the runs, nullptr turns it off.
+  void SetConvergenceLog(ConvergenceWriter* log);
+
+  // Every run writes a snapshot of its state to `path` once every `interval`
+  // generations, replacing the previous one. An interval of 0 turns it off.
+  void SetCheckpoint(std::string path, size_t interval);
+  // The next run continues from the snapshot at `path` instead of starting
+  // from the initial population. Started with the same strategy, parameters,
+  // iterations and objective it continues bit identically to the run that
+  // wrote the snapshot, returning only the generations after it.
+  void ResumeFrom(std::string path);
+
+  // Per-phase cycles and counters summed over all runs since the last reset.
+  // Only filled when built with DIFF_EVO_INSTRUMENT, ToJson dumps them.
+  [[nodiscard]] const instrumentation_t& GetInstrumentation() const;
+  void ResetInstrumentation();
+
+  // Objective evaluations spent by the last run, initial population
+  // included. A resumed run also counts those before its snapshot.
+  [[nodiscard]] size_t GetEvaluations() const;
+
+  // Runs DiffEvoEngine<MUTATION, CROSSOVER, DIM> on the initial population
+  // and limits of this instance. DIM has to match the population dimension
+  // when it is given, PRECISION selects float or mixed precision genes (see
+  // precision_structure).
+  template <size_t DIM = std::dynamic_extent,
+            typename PRECISION = double_precision_t, typename MUTATION,
+            typename CROSSOVER, typename FUN>
+    requires Objective<FUN, PRECISION>
+  std::vector<de_t> Optimize(size_t iterations, MUTATION mutation,
+                             CROSSOVER crossover, FUN fun);
+
+  // Ask/tell optimizer over the initial population and limits of this
+  // instance, for objectives evaluated outside of DiffEvo.
+  template <typename MUTATION, typename CROSSOVER = BinomialCrossover>
+  AskTell<MUTATION, CROSSOVER> MakeAskTell(MUTATION mutation,
+                                           AskTellMode mode,
+                                           CROSSOVER crossover = CROSSOVER{});
+
   template <typename FUN>
-    requires std::invocable<FUN, de_t*>
+    requires Objective<FUN>
   std::vector<de_t> Rand1(size_t iterations, double mutation_rate,
                           double cross_rate, FUN fun);
 
   template <typename FUN>
-    requires std::invocable<FUN, de_t*>
+    requires Objective<FUN>
   std::vector<de_t> Best1(size_t iterations, double mutation_rate,
                           double cross_rate, FUN fun);
 
   template <typename FUN>
-    requires std::invocable<FUN, de_t *>
+    requires Objective<FUN>
   std::vector<de_t> jDE(size_t iterations, double mutation_rate,
                         double cross_rate, double tau1, double tau2, FUN fun);
 
+  // L-SHADE with its published settings, the initial population shrinks to
+  // 4 individuals over `iterations`. Optimize with an LshadeMutation takes
+  // other settings.
+  template <typename FUN>
+    requires Objective<FUN>
+  std::vector<de_t> LShade(size_t iterations, FUN fun);
+
  private:
-  std::vector<de_t> initial_population_;
+  pop_t initial_population_;
+  limits_t limits_;
   std::random_device rd_;
   std::mt19937 gen_;
   std::uniform_real_distribution<> distrib_;
+  ParallelRunner runner_;
+  island_config_t islands_;
+  ConvergenceWriter* log_ = nullptr;
+  instrumentation_t instrumentation_;
+  size_t evaluations_ = 0;
+  std::string checkpoint_path_;
+  size_t checkpoint_interval_ = 0;
+  std::string resume_path_;
 
   bool OptimizeInitTest(std::string& err);
 };
 
-#include "diff_evo.tpp"
\ No newline at end of file
+#include "diff_evo.tpp"
@@ -1,280 +1,111 @@
 #pragma once
 
-#include <algorithm>
 #include <format>
 #include <stdexcept>
+#include <utility>
+
+template <size_t DIM, typename PRECISION, typename MUTATION,
+          typename CROSSOVER, typename FUN>
+  requires Objective<FUN, PRECISION>
+std::vector<de_t> DiffEvo::Optimize(size_t iterations, MUTATION mutation,
+                                    CROSSOVER crossover, FUN fun) {
+  const auto resume = std::exchange(resume_path_, {});
+  evaluations_ = 0;
+  if (resume.empty()) {
+    if (std::string err_msg; !OptimizeInitTest(err_msg)) {
+      throw std::runtime_error(err_msg);
+    }
 
-template <typename FUN>
-  requires std::invocable<FUN, de_t *>
-std::vector<de_t> DiffEvo::Rand1( size_t iterations,
-                                  double mutation_rate,
-                                  double cross_rate, FUN fun) {
-
-  if (std::string err_msg; !OptimizeInitTest(err_msg)) {
-    throw std::runtime_error(err_msg);
+    if (initial_population_.size < 4) return {};
   }
 
-  std::vector<de_t> output;
-  auto start_population = initial_population_;
-
-  if (start_population.size() < 4) return output;
-
-  const auto size = start_population.size();
-  const auto dim = start_population[0].weight.size();
-
-  std::ranges::for_each(start_population, [](auto &individual) {
-    for (int i = 0; i < individual.weight.size(); ++i) {
-        if (individual.weight[i] < individual.min_limits[i]) {
-          individual.weight[i] = individual.min_limits[i];
-        }
-        if (individual.weight[i] > individual.max_limits[i]) {
-          individual.weight[i] = individual.max_limits[i];
-        }
-
+  if (islands_.islands > 1) {
+    if (!resume.empty() || checkpoint_interval_ > 0) {
+      throw std::invalid_argument(
+          "checkpoints are not supported with more than one island");
     }
-  });
-
-  std::ranges::for_each(start_population, [&](auto &v) { fun(&v); });
-
-  auto counter = start_population.size();
-  std::vector<de_t> population(size);
-  while (counter < iterations) {
-    population.clear();
-    while (population.size() < size) {
-      de_t new_des;
-      new_des.weight.resize(dim);
-      new_des.min_limits = start_population[0].min_limits;
-      new_des.max_limits = start_population[0].max_limits;
-
-      std::vector<int> indices(start_population.size());
-      std::ranges::iota(indices, 0);
-
-      std::ranges::shuffle(indices, gen_);
-
-      int x1_idx = indices[0];
-      int x2_idx = indices[1];
-      int x3_idx = indices[2];
-
-      // mutate
-      for (int i = 0; i < dim; ++i) {
-        new_des.weight[i] =
-            start_population[x1_idx].weight[i] +
-            mutation_rate * (start_population[x2_idx].weight[i] -
-                             start_population[x3_idx].weight[i]);
-      }
-
-      // crossing
-      for (int i = 0; i < dim; ++i) {
-        new_des.weight[i] = distrib_(gen_) > cross_rate
-                                ? start_population[x1_idx].weight[i]
-                                : new_des.weight[i];
-
-        if (new_des.weight[i] < new_des.min_limits[i]) {
-          new_des.weight[i] = new_des.min_limits[i];
-        }
-        if (new_des.weight[i] > new_des.max_limits[i]) {
-          new_des.weight[i] = new_des.max_limits[i];
-        }
-      }
-
-      fun(&new_des);
-      population.push_back(new_des);
-      counter++;
+    IslandModel<MUTATION, CROSSOVER, DIM, PRECISION> model(
+        islands_, std::move(mutation), std::move(crossover), limits_, gen_());
+    std::vector<de_t> output;
+    if (log_) {
+      model.Run(initial_population_, iterations, fun, *log_);
+    } else {
+      output = model.Run(initial_population_, iterations, fun);
     }
-
-    start_population = population;
-    output.emplace_back(*std::ranges::min_element(
-        start_population,
-        [&](const auto &a, const auto &b) { return a.cost < b.cost; }));
+    instrumentation_ += model.Instrumentation();
+    const auto &evaluations = model.Evaluations();
+    evaluations_ =
+        evaluations.empty() ? initial_population_.size : evaluations.back();
+    return output;
   }
 
-  return output;
-}
-
-template <typename FUN>
-  requires std::invocable<FUN, de_t *>
-std::vector<de_t> DiffEvo::Best1( size_t iterations,
-                                  double mutation_rate,
-                                  double cross_rate, FUN fun) {
-  if (std::string err_msg; !OptimizeInitTest(err_msg)) {
-    throw std::runtime_error(err_msg);
+  DiffEvoEngine<MUTATION, CROSSOVER, DIM, Philox4x32, PRECISION> engine(
+      std::move(mutation), std::move(crossover), limits_, gen_(), &runner_);
+  engine.SetCheckpoint(checkpoint_path_, checkpoint_interval_);
+  if (resume.empty()) {
+    engine.Init(initial_population_, fun);
+  } else {
+    const Snapshot snapshot(resume);
+    engine.Restore(snapshot.View());
   }
 
-  std::vector<de_t> output;
-  auto start_population = initial_population_;
-
-  if (start_population.size() < 4) return output;
-
-  const auto size = start_population.size();
-  const auto dim = start_population[0].weight.size();
-
-  std::ranges::for_each(start_population, [](auto &individual) {
-    for (int i = 0; i < individual.weight.size(); ++i) {
-        if (individual.weight[i] < individual.min_limits[i]) {
-          individual.weight[i] = individual.min_limits[i];
-        }
-        if (individual.weight[i] > individual.max_limits[i]) {
-          individual.weight[i] = individual.max_limits[i];
-        }
-
-    }
-  });
-
-  std::ranges::for_each(start_population, [&](auto &v) { fun(&v); });
-
-  auto counter = start_population.size();
-  std::vector<de_t> population(size);
-  while (counter < iterations) {
-    population.clear();
-    while (population.size() < size) {
-      de_t new_des;
-      new_des.weight.resize(dim);
-      new_des.min_limits = start_population[0].min_limits;
-      new_des.max_limits = start_population[0].max_limits;
-
-      auto best = std::ranges::min_element(
-          start_population,
-          [&](const auto &a, const auto &b) { return a.cost < b.cost; });
-
-      // gen indexes
-      const auto best_idx = std::ranges::distance(start_population.begin(), best);
-      std::vector<int> indices(start_population.size());
-      std::iota(indices.begin(), indices.end(), 0);
-
-      indices.erase(indices.begin() + best_idx);
-      std::ranges::shuffle(indices, gen_);
-
-      const int x2_idx = indices[0];
-      const int x3_idx = indices[1];
-
-      // mutation
-      for (int i = 0; i < dim; ++i) {
-        new_des.weight[i] =
-            best->weight[i] +
-            mutation_rate * (start_population[x2_idx].weight[i] -
-                             start_population[x3_idx].weight[i]);
-      }
-
-      // crossing
-      for (int i = 0; i < dim; ++i) {
-        new_des.weight[i] =
-            distrib_(gen_) > cross_rate ? best->weight[i] : new_des.weight[i];
-        if (new_des.weight[i] < new_des.min_limits[i]) {
-          new_des.weight[i] = new_des.min_limits[i];
-        }
-        if (new_des.weight[i] > new_des.max_limits[i]) {
-          new_des.weight[i] = new_des.max_limits[i];
-        }
-      }
-      fun(&new_des);
-      population.push_back(new_des);
-      counter++;
-    }
-
-    start_population = population;
-    output.emplace_back(*std::ranges::min_element(
-        start_population,
-        [&](const auto &a, const auto &b) { return a.cost < b.cost; }));
+  if (log_) {
+    engine.Continue(iterations, fun, *log_);
+    instrumentation_ += engine.Instrumentation();
+    evaluations_ = engine.Evaluations();
+    return {};
   }
-
+  auto output = engine.Continue(iterations, fun);
+  instrumentation_ += engine.Instrumentation();
+  evaluations_ = engine.Evaluations();
   return output;
 }
 
-
-template <typename FUN>
-  requires std::invocable<FUN, de_t *>
-std::vector<de_t> DiffEvo::jDE( size_t iterations,
-                                  double mutation_rate,
-                                  double cross_rate, double tau1, double tau2,
-                                  FUN fun) {
+template <typename MUTATION, typename CROSSOVER>
+AskTell<MUTATION, CROSSOVER> DiffEvo::MakeAskTell(MUTATION mutation,
+                                                  AskTellMode mode,
+                                                  CROSSOVER crossover) {
   if (std::string err_msg; !OptimizeInitTest(err_msg)) {
     throw std::runtime_error(err_msg);
   }
 
-  std::vector<de_t> output;
-  auto start_population = initial_population_;
-  std::uniform_real_distribution f_dist(0.1, 0.9);
-
-
-  if (start_population.size() < 4) return output;
-
-  const auto size = start_population.size();
-  const auto dim = start_population[0].weight.size();
-
-  std::ranges::for_each(start_population, [](auto &individual) {
-    for (int i = 0; i < individual.weight.size(); ++i) {
-        if (individual.weight[i] < individual.min_limits[i]) {
-          individual.weight[i] = individual.min_limits[i];
-        }
-        if (individual.weight[i] > individual.max_limits[i]) {
-          individual.weight[i] = individual.max_limits[i];
-        }
-
-    }
-  });
-
-  std::ranges::for_each(start_population, [&](auto &v) { fun(&v); });
-
-  auto counter = start_population.size();
-  std::vector<de_t> population(size);
-  while (counter < iterations) {
-    population.clear();
-    while (population.size() < size) {
-      de_t new_des;
-      new_des.weight.resize(dim);
-      new_des.min_limits = start_population[0].min_limits;
-      new_des.max_limits = start_population[0].max_limits;
-
-      if (distrib_(gen_) < tau1) {
-        cross_rate = distrib_(gen_);
-      }
-      if (distrib_(gen_) < tau2) {
-        mutation_rate = f_dist(gen_);
-      }
-
-      // gen indexes
-      std::vector<int> indices(start_population.size());
-      std::ranges::iota(indices, 0);
-
-      std::ranges::shuffle(indices, gen_);
-
-      int x1_idx = indices[0];
-      int x2_idx = indices[1];
-      int x3_idx = indices[2];
-
-      // mutate
-      for (int i = 0; i < dim; ++i) {
-        new_des.weight[i] =
-            start_population[x1_idx].weight[i] +
-            mutation_rate * (start_population[x2_idx].weight[i] -
-                             start_population[x3_idx].weight[i]);
-      }
-
-      // crossing
-      for (int i = 0; i < dim; ++i) {
-        new_des.weight[i] = distrib_(gen_) > cross_rate
-                                ? start_population[x1_idx].weight[i]
-                                : new_des.weight[i];
-        if (new_des.weight[i] < new_des.min_limits[i]) {
-          new_des.weight[i] = new_des.min_limits[i];
-        }
-        if (new_des.weight[i] > new_des.max_limits[i]) {
-          new_des.weight[i] = new_des.max_limits[i];
-        }
-      }
-
-      fun(&new_des);
-      population.push_back(new_des);
-      counter++;
-    }
+  return AskTell<MUTATION, CROSSOVER>(initial_population_, limits_,
+                                      std::move(mutation),
+                                      std::move(crossover), mode, gen_());
+}
 
-    start_population = population;
-    output.emplace_back(*std::ranges::min_element(
-        start_population,
-        [&](const auto &a, const auto &b) { return a.cost < b.cost; }));
+template <typename FUN>
+  requires Objective<FUN>
+std::vector<de_t> DiffEvo::Rand1(size_t iterations, double mutation_rate,
+                                 double cross_rate, FUN fun) {
+  return Optimize(iterations, Rand1Mutation{{mutation_rate, cross_rate}},
+                  BinomialCrossover{}, std::move(fun));
+}
 
+template <typename FUN>
+  requires Objective<FUN>
+std::vector<de_t> DiffEvo::Best1(size_t iterations, double mutation_rate,
+                                 double cross_rate, FUN fun) {
+  return Optimize(iterations, Best1Mutation{{mutation_rate, cross_rate}},
+                  BinomialCrossover{}, std::move(fun));
+}
 
-  }
+template <typename FUN>
+  requires Objective<FUN>
+std::vector<de_t> DiffEvo::jDE(size_t iterations, double mutation_rate,
+                               double cross_rate, double tau1, double tau2,
+                               FUN fun) {
+  return Optimize(iterations,
+                  JdeMutation{{mutation_rate, cross_rate}, tau1, tau2, {}},
+                  BinomialCrossover{}, std::move(fun));
+}
 
-  return output;
-}
\ No newline at end of file
+template <typename FUN>
+  requires Objective<FUN>
+std::vector<de_t> DiffEvo::LShade(size_t iterations, FUN fun) {
+  // islands shrink over their own share of the budget
+  const auto budget =
+      islands_.islands > 1 ? iterations / islands_.islands : iterations;
+  return Optimize(iterations, LshadeMutation{budget},
+                  BinomialCrossover{.force_mutant_gene = true}, std::move(fun));
+}
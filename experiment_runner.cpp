@@ -0,0 +1,71 @@
+/*
+ * Created by kureii on 11/15/24.
+ */
+
+#include "experiment_runner.h"
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <thread>
+
+#include "diff_evo.h"
+#include "thread_pool.h"
+
+ExperimentRunner::ExperimentRunner(size_t threads)
+    : threads_(threads != 0
+                   ? threads
+                   : std::max(1u, std::thread::hardware_concurrency())) {}
+
+size_t ExperimentRunner::Add(experiment_job_t job) {
+  jobs_.push_back(std::move(job));
+  return jobs_.size() - 1;
+}
+
+const std::vector<experiment_job_t> &ExperimentRunner::Jobs() const {
+  return jobs_;
+}
+
+std::vector<std::vector<de_t>> ExperimentRunner::Run() const {
+  std::vector<std::vector<de_t>> results(jobs_.size());
+  ThreadPool pool(std::min(threads_, std::max<size_t>(jobs_.size(), 1)));
+
+  // jobs take very different times, so every worker pulls the next one
+  std::atomic<size_t> next = 0;
+  pool.ParallelFor(pool.Size(), [&](size_t, size_t, size_t) {
+    for (auto i = next++; i < jobs_.size(); i = next++) {
+      results[i] = RunJob(jobs_[i]);
+    }
+  });
+
+  return results;
+}
+
+std::vector<de_t> ExperimentRunner::RunJob(const experiment_job_t &job) {
+  DiffEvo diff_evo(job.seed);
+  diff_evo.GenerateInitPopulation(job.dimensions, job.population_size);
+  diff_evo.AddMinLimits(job.min_limit);
+  diff_evo.AddMaxLimits(job.max_limit);
+
+  std::unique_ptr<ConvergenceWriter> log;
+  if (!job.log_path.empty()) {
+    log = std::make_unique<ConvergenceWriter>(job.log_path, job.dimensions,
+                                              job.log_genome);
+    diff_evo.SetConvergenceLog(log.get());
+  }
+
+  switch (job.strategy) {
+    case Strategy::kRand1:
+      return diff_evo.Rand1(job.iterations, job.mutation_rate, job.cross_rate,
+                            job.function);
+    case Strategy::kBest1:
+      return diff_evo.Best1(job.iterations, job.mutation_rate, job.cross_rate,
+                            job.function);
+    case Strategy::kJde:
+      return diff_evo.jDE(job.iterations, job.mutation_rate, job.cross_rate,
+                          job.tau1, job.tau2, job.function);
+    case Strategy::kLshade:
+      return diff_evo.LShade(job.iterations, job.function);
+  }
+  return {};
+}
@@ -0,0 +1,62 @@
+/*
+ * Created by kureii on 11/15/24.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "structures.h"
+
+enum class Strategy { kRand1, kBest1, kJde, kLshade };
+
+// One optimizer run: objective, strategy, its parameters and the seed of the
+// DiffEvo that runs it.
+struct experiment_job_structure {
+  std::string name;
+  std::function<void(de_t *)> function;
+  Strategy strategy = Strategy::kRand1;
+  size_t dimensions = 0;
+  size_t population_size = 0;
+  size_t iterations = 0;
+  double min_limit = 0.0;
+  double max_limit = 0.0;
+  double mutation_rate = 0.5;
+  double cross_rate = 0.8;
+  // jDE only, L-SHADE adapts its own rates
+  double tau1 = 0.1;
+  double tau2 = 0.1;
+  uint64_t seed = 0;
+  // When set, the run streams its history into a ConvergenceWriter at this
+  // path and its in-memory history stays empty.
+  std::string log_path;
+  bool log_genome = false;
+};
+
+using experiment_job_t = experiment_job_structure;
+
+// Runs a batch of jobs over a thread pool, each on its own DiffEvo seeded
+// from the job. A job's result depends only on the job itself, so the output
+// is the same for any number of threads.
+class ExperimentRunner {
+ public:
+  // 0 uses one thread per hardware thread.
+  explicit ExperimentRunner(size_t threads = 0);
+
+  // Returns the index of the job in the results of Run.
+  size_t Add(experiment_job_t job);
+  [[nodiscard]] const std::vector<experiment_job_t> &Jobs() const;
+
+  // Returns the per-generation history of every job, in the order they were
+  // added.
+  std::vector<std::vector<de_t>> Run() const;
+
+  static std::vector<de_t> RunJob(const experiment_job_t &job);
+
+ private:
+  size_t threads_;
+  std::vector<experiment_job_t> jobs_;
+};
@@ -0,0 +1,111 @@
+/*
+ * Created by kureii on 11/15/24.
+ */
+
+#include "instrumentation.h"
+
+#include <chrono>
+#include <format>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+namespace instrument {
+
+namespace {
+
+thread_local counters_structure *sink = nullptr;
+thread_local PhaseTimer *active = nullptr;
+
+uint64_t Now() {
+#if defined(__x86_64__) || defined(__i386__)
+  return __rdtsc();
+#else
+  return std::chrono::steady_clock::now().time_since_epoch().count();
+#endif
+}
+
+}  // namespace
+
+counters_structure &counters_structure::operator+=(
+    const counters_structure &other) {
+  for (size_t p = 0; p < kPhases; ++p) {
+    phases[p].cycles += other.phases[p].cycles;
+    phases[p].calls += other.phases[p].calls;
+  }
+  allocations += other.allocations;
+  clamped_genes += other.clamped_genes;
+  children += other.children;
+  return *this;
+}
+
+counters_structure *Sink() { return sink; }
+
+ScopedSink::ScopedSink(counters_structure &counters) : previous_(sink) {
+  sink = &counters;
+}
+
+ScopedSink::~ScopedSink() { sink = previous_; }
+
+PhaseTimer::PhaseTimer(Phase phase)
+    : phase_(phase), start_(Now()), parent_(active) {
+  active = this;
+}
+
+PhaseTimer::~PhaseTimer() {
+  const auto elapsed = Now() - start_;
+  active = parent_;
+  if (parent_) parent_->nested_ += elapsed;
+  if (!sink) return;
+
+  auto &entry = sink->phases[static_cast<size_t>(phase_)];
+  entry.cycles += elapsed - nested_;
+  ++entry.calls;
+}
+
+const char *Name(Phase phase) {
+  switch (phase) {
+    case Phase::kDonors:
+      return "donors";
+    case Phase::kMutation:
+      return "mutation";
+    case Phase::kCrossover:
+      return "crossover";
+    case Phase::kEvaluation:
+      return "evaluation";
+    case Phase::kSelection:
+      return "selection";
+    case Phase::kReporting:
+      return "reporting";
+  }
+  return "unknown";
+}
+
+}  // namespace instrument
+
+std::string ToJson(const instrumentation_t &counters) {
+  uint64_t total = 0;
+  for (const auto &phase : counters.phases) {
+    total += phase.cycles;
+  }
+  const auto evaluation =
+      counters.phases[static_cast<size_t>(instrument::Phase::kEvaluation)]
+          .cycles;
+
+  auto json = std::format(R"({{"enabled": {}, "phases": {{)",
+                          instrument::kEnabled);
+  for (size_t p = 0; p < instrument::kPhases; ++p) {
+    json += std::format(R"({}"{}": {{"cycles": {}, "calls": {}}})",
+                        p ? ", " : "",
+                        instrument::Name(static_cast<instrument::Phase>(p)),
+                        counters.phases[p].cycles, counters.phases[p].calls);
+  }
+  json += std::format(
+      R"(}}, "allocations": {}, "clamped_genes": {}, "children": {}, )"
+      R"("evaluation_share": {}}})",
+      counters.allocations, counters.clamped_genes, counters.children,
+      total ? static_cast<double>(evaluation) / static_cast<double>(total)
+            : 0.0);
+  return json;
+}
@@ -0,0 +1,122 @@
+/*
+ * Created by kureii on 11/15/24.
+ */
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string>
+
+// Per-phase cycle counts and counters of the DE hot path. Everything is
+// compiled in only with DIFF_EVO_INSTRUMENT defined (CMake option
+// DIFF_EVO_INSTRUMENT); otherwise the macros below expand to nothing and
+// the counters stay zero.
+//
+// Cycles are exclusive: time spent in a nested phase (donor selection inside
+// mutation) is only counted for the nested one.
+//
+// Allocations are only counted by programs that also link the
+// diff_evo_allocation_hook target, which replaces the global operator new
+// and delete in every form. Others keep their own allocator and see zero.
+namespace instrument {
+
+enum class Phase {
+  kDonors,
+  kMutation,
+  kCrossover,
+  kEvaluation,
+  kSelection,
+  kReporting,
+};
+
+inline constexpr size_t kPhases = 6;
+
+#ifdef DIFF_EVO_INSTRUMENT
+inline constexpr bool kEnabled = true;
+#else
+inline constexpr bool kEnabled = false;
+#endif
+
+struct phase_structure {
+  uint64_t cycles = 0;
+  uint64_t calls = 0;
+};
+
+// Engines keep one per chunk in a vector, the alignment keeps the chunks of
+// different threads off each other's cache lines.
+struct alignas(64) counters_structure {
+  std::array<phase_structure, kPhases> phases{};
+  uint64_t allocations = 0;
+  uint64_t clamped_genes = 0;
+  uint64_t children = 0;
+
+  counters_structure &operator+=(const counters_structure &other);
+};
+
+// Counters of the calling thread while a ScopedSink is alive, nullptr
+// otherwise.
+counters_structure *Sink();
+
+// Routes the instrumentation of the calling thread into `counters`.
+class ScopedSink {
+ public:
+  explicit ScopedSink(counters_structure &counters);
+  ~ScopedSink();
+
+  ScopedSink(const ScopedSink &) = delete;
+  ScopedSink &operator=(const ScopedSink &) = delete;
+
+ private:
+  counters_structure *previous_;
+};
+
+// Adds the cycles between construction and destruction to `phase` of the
+// current sink.
+class PhaseTimer {
+ public:
+  explicit PhaseTimer(Phase phase);
+  ~PhaseTimer();
+
+  PhaseTimer(const PhaseTimer &) = delete;
+  PhaseTimer &operator=(const PhaseTimer &) = delete;
+
+ private:
+  Phase phase_;
+  uint64_t start_;
+  uint64_t nested_ = 0;
+  PhaseTimer *parent_;
+};
+
+// Short name used as the JSON key of `phase`.
+const char *Name(Phase phase);
+
+}  // namespace instrument
+
+using instrumentation_t = instrument::counters_structure;
+
+// {"enabled": ..., "phases": {"donors": {"cycles": ..., "calls": ...}, ...},
+//  "allocations": ..., "clamped_genes": ..., "children": ...,
+//  "evaluation_share": ...}
+std::string ToJson(const instrumentation_t &counters);
+
+#ifdef DIFF_EVO_INSTRUMENT
+#define DIFF_EVO_CONCAT_IMPL(a, b) a##b
+#define DIFF_EVO_CONCAT(a, b) DIFF_EVO_CONCAT_IMPL(a, b)
+#define DIFF_EVO_PHASE(phase)                                          \
+  ::instrument::PhaseTimer DIFF_EVO_CONCAT(diff_evo_phase_, __LINE__)( \
+      ::instrument::Phase::phase)
+#define DIFF_EVO_SINK(counters)                                       \
+  ::instrument::ScopedSink DIFF_EVO_CONCAT(diff_evo_sink_, __LINE__)( \
+      counters)
+#define DIFF_EVO_COUNT(field, n)                      \
+  do {                                                \
+    if (auto *diff_evo_sink = ::instrument::Sink()) { \
+      diff_evo_sink->field += (n);                    \
+    }                                                 \
+  } while (false)
+#else
+#define DIFF_EVO_PHASE(phase) static_cast<void>(0)
+#define DIFF_EVO_SINK(counters) static_cast<void>(0)
+#define DIFF_EVO_COUNT(field, n) static_cast<void>(0)
+#endif
@@ -0,0 +1,137 @@
+/*
+ * Created by kureii on 11/15/24.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <vector>
+
+#include "convergence_log.h"
+#include "de_engine.h"
+#include "spsc_queue.h"
+#include "structures.h"
+
+enum class MigrationTopology {
+  kRing,            // island i sends to island i + 1
+  kFullyConnected,  // every island sends to every other island
+};
+
+struct island_config_structure {
+  size_t islands = 1;
+  // generations between two emigrations of an island
+  size_t migration_interval = 10;
+  // best individuals sent along every edge per emigration
+  size_t migrants = 1;
+  MigrationTopology topology = MigrationTopology::kRing;
+};
+
+using island_config_t = island_config_structure;
+
+// Splits the population into `config.islands` sub-populations, each evolved
+// by its own DiffEvoEngine on its own thread. Islands never wait for each
+// other: migrants go through one SpscQueue per directed edge, a full queue
+// drops the migrant and an island takes in whatever has arrived at the end
+// of each of its generations. Migrants travel in double whatever the
+// PRECISION of the engines.
+template <typename MUTATION, typename CROSSOVER = BinomialCrossover,
+          size_t DIM = std::dynamic_extent,
+          typename PRECISION = double_precision_t>
+class IslandModel {
+ public:
+  IslandModel(island_config_t config, MUTATION mutation, CROSSOVER crossover,
+              limits_t limits, uint64_t seed);
+
+  // Spends `iterations` evaluations in total, split evenly among the islands
+  // with the remainder going one each to the first ones. Every island calls
+  // its own copy of `fun`. Returns, per generation, the best individual over
+  // all islands.
+  template <typename FUN>
+    requires Objective<FUN, PRECISION>
+  std::vector<de_t> Run(const pop_t &initial_population, size_t iterations,
+                        const FUN &fun);
+  // Same as Run, but every generation is appended to `log` as soon as all
+  // islands have finished it instead of being returned. Islands still keep
+  // their own records, allocated up front so their steps do not allocate.
+  template <typename FUN>
+    requires Objective<FUN, PRECISION>
+  void Run(const pop_t &initial_population, size_t iterations,
+           const FUN &fun, ConvergenceWriter &log);
+
+  // Counters of all islands of the last Run, see DiffEvoEngine.
+  [[nodiscard]] const instrumentation_t &Instrumentation() const;
+  // Per generation of the last Run, the evaluations all islands had spent
+  // by the end of their own generation of that index.
+  [[nodiscard]] const std::vector<size_t> &Evaluations() const;
+
+ private:
+  using engine_t =
+      DiffEvoEngine<MUTATION, CROSSOVER, DIM, Philox4x32, PRECISION>;
+
+  struct migrant_structure {
+    double cost;
+    std::vector<double> weight;
+  };
+
+  // Published by each island after every generation, on its own cache line.
+  struct alignas(64) progress_structure {
+    std::atomic<size_t> generations = 0;
+    std::atomic<bool> finished = false;
+  };
+
+  island_config_t config_;
+  MUTATION mutation_;
+  CROSSOVER crossover_;
+  limits_t limits_;
+  uint64_t seed_;
+  instrumentation_t instrumentation_;
+  std::vector<size_t> evaluations_;
+
+  // state of the last Run, per island
+  std::vector<engine_t> engines_;
+  std::vector<std::vector<de_t>> histories_;
+  std::vector<std::vector<size_t>> island_evaluations_;
+  std::unique_ptr<progress_structure[]> progress_;
+
+  // set for the whole of a Run
+  ConvergenceWriter *log_ = nullptr;
+  // guards logged_, done_ and resizing the records above
+  std::mutex log_mutex_;
+  size_t logged_ = 0;
+  std::vector<size_t> done_;
+
+  // queues_[from * islands + to], empty for edges not in the topology
+  std::vector<std::unique_ptr<SpscQueue<migrant_structure>>> queues_;
+
+  void BuildQueues(size_t dim);
+
+  // Evolves all islands until they have spent `iterations` evaluations.
+  template <typename FUN>
+  void RunIslands(const pop_t &initial_population, size_t iterations,
+                  const FUN &fun);
+
+  template <typename FUN>
+  void RunIsland(size_t island, const pop_t &population, size_t iterations,
+                 FUN fun, std::atomic<bool> &stop);
+
+  // Best individual of generation `g` over the islands that ran it, `done`
+  // holding the generations each island has finished. Adds the evaluations
+  // all islands had spent by then to `evaluations`, islands that stopped
+  // earlier with their final total.
+  const de_t &Merge(size_t g, std::span<const size_t> done,
+                    size_t &evaluations) const;
+
+  // Appends every generation all islands are done with to log_, islands
+  // that returned are done with all of theirs. Needs log_mutex_.
+  void Flush();
+
+  void Emigrate(size_t island, const engine_t &engine,
+                migrant_structure &migrant);
+  void Immigrate(size_t island, engine_t &engine, migrant_structure &migrant);
+};
+
+#include "island_model.tpp"
@@ -0,0 +1,306 @@
+#pragma once
+
+#include <algorithm>
+#include <exception>
+#include <limits>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
+template <typename MUTATION, typename CROSSOVER, size_t DIM, typename PRECISION>
+IslandModel<MUTATION, CROSSOVER, DIM, PRECISION>::IslandModel(
+    island_config_t config, MUTATION mutation, CROSSOVER crossover,
+    limits_t limits, uint64_t seed)
+    : config_(config),
+      mutation_(std::move(mutation)),
+      crossover_(std::move(crossover)),
+      limits_(std::move(limits)),
+      seed_(seed) {
+  if (config_.islands == 0 || config_.migration_interval == 0) {
+    throw std::invalid_argument(
+        "islands and migration_interval must be greater than 0");
+  }
+}
+
+template <typename MUTATION, typename CROSSOVER, size_t DIM, typename PRECISION>
+template <typename FUN>
+  requires Objective<FUN, PRECISION>
+std::vector<de_t> IslandModel<MUTATION, CROSSOVER, DIM, PRECISION>::Run(
+    const pop_t &initial_population, size_t iterations, const FUN &fun) {
+  log_ = nullptr;
+  RunIslands(initial_population, iterations, fun);
+
+  std::vector<de_t> output(evaluations_.size());
+  for (size_t g = 0; g < output.size(); ++g) {
+    size_t evaluations = 0;
+    output[g] = Merge(g, done_, evaluations);
+  }
+  return output;
+}
+
+template <typename MUTATION, typename CROSSOVER, size_t DIM, typename PRECISION>
+template <typename FUN>
+  requires Objective<FUN, PRECISION>
+void IslandModel<MUTATION, CROSSOVER, DIM, PRECISION>::Run(
+    const pop_t &initial_population, size_t iterations, const FUN &fun,
+    ConvergenceWriter &log) {
+  log_ = &log;
+  RunIslands(initial_population, iterations, fun);
+  log_ = nullptr;
+}
+
+template <typename MUTATION, typename CROSSOVER, size_t DIM, typename PRECISION>
+template <typename FUN>
+void IslandModel<MUTATION, CROSSOVER, DIM, PRECISION>::RunIslands(
+    const pop_t &initial_population, size_t iterations, const FUN &fun) {
+  const auto islands = config_.islands;
+  if (initial_population.size < 4 * islands) {
+    throw std::invalid_argument(
+        "population needs at least 4 individuals per island");
+  }
+
+  BuildQueues(initial_population.dim);
+
+  // island k gets rows k, k + islands, k + 2 * islands, ...
+  std::vector<pop_t> populations(islands);
+  for (size_t k = 0; k < islands; ++k) {
+    auto &population = populations[k];
+    population.Resize((initial_population.size - k + islands - 1) / islands,
+                      initial_population.dim);
+    for (size_t j = 0; j < population.size; ++j) {
+      const auto row = k + j * islands;
+      std::ranges::copy(initial_population.Row(row),
+                        population.Row(j).begin());
+      population.costs[j] = initial_population.costs[row];
+    }
+  }
+
+  // islands share the seed and tell their streams apart by the run index
+  engines_.clear();
+  engines_.reserve(islands);
+  for (size_t k = 0; k < islands; ++k) {
+    engines_.emplace_back(mutation_, crossover_, limits_, seed_, nullptr,
+                          static_cast<uint32_t>(k));
+  }
+
+  // the remainder goes to the first islands, which also got the extra rows
+  std::vector<size_t> budgets(islands, iterations / islands);
+  for (size_t k = 0; k < iterations % islands; ++k) ++budgets[k];
+
+  histories_.assign(islands, {});
+  island_evaluations_.assign(islands, {});
+  progress_ = std::make_unique<progress_structure[]>(islands);
+  done_.assign(islands, 0);
+  logged_ = 0;
+
+  std::vector<std::exception_ptr> errors(islands);
+  std::atomic<bool> stop = false;
+  {
+    std::vector<std::jthread> threads;
+    threads.reserve(islands);
+    for (size_t k = 0; k < islands; ++k) {
+      threads.emplace_back([&, k] {
+        try {
+          RunIsland(k, populations[k], budgets[k], fun, stop);
+        } catch (...) {
+          errors[k] = std::current_exception();
+          stop = true;
+        }
+        progress_[k].finished.store(true, std::memory_order_release);
+      });
+    }
+  }
+
+  for (const auto &error : errors) {
+    if (error) std::rethrow_exception(error);
+  }
+
+  instrumentation_ = {};
+  for (const auto &engine : engines_) {
+    instrumentation_ += engine.Instrumentation();
+  }
+
+  // whatever the islands did not get to append themselves
+  if (log_) Flush();
+
+  size_t generations = 0;
+  for (size_t k = 0; k < islands; ++k) {
+    done_[k] = histories_[k].size();
+    generations = std::max(generations, done_[k]);
+  }
+  evaluations_.assign(generations, 0);
+  for (size_t g = 0; g < generations; ++g) {
+    Merge(g, done_, evaluations_[g]);
+  }
+}
+
+template <typename MUTATION, typename CROSSOVER, size_t DIM, typename PRECISION>
+const de_t &IslandModel<MUTATION, CROSSOVER, DIM, PRECISION>::Merge(
+    size_t g, std::span<const size_t> done, size_t &evaluations) const {
+  const de_t *best = nullptr;
+  for (size_t k = 0; k < config_.islands; ++k) {
+    if (g >= done[k]) {
+      evaluations += engines_[k].Evaluations();
+      continue;
+    }
+    evaluations += island_evaluations_[k][g];
+    const auto &record = histories_[k][g];
+    if (!best || record.cost < best->cost) best = &record;
+  }
+  return *best;
+}
+
+template <typename MUTATION, typename CROSSOVER, size_t DIM, typename PRECISION>
+void IslandModel<MUTATION, CROSSOVER, DIM, PRECISION>::Flush() {
+  // finished is read before generations, so a finished island's count is
+  // its final one and nothing below it is still being written
+  auto ready = std::numeric_limits<size_t>::max();
+  size_t longest = 0;
+  for (size_t k = 0; k < config_.islands; ++k) {
+    const auto finished =
+        progress_[k].finished.load(std::memory_order_acquire);
+    done_[k] = progress_[k].generations.load(std::memory_order_acquire);
+    longest = std::max(longest, done_[k]);
+    if (!finished) ready = std::min(ready, done_[k]);
+  }
+  ready = std::min(ready, longest);
+
+  for (; logged_ < ready; ++logged_) {
+    size_t evaluations = 0;
+    const auto &best = Merge(logged_, done_, evaluations);
+    log_->Append(logged_ + 1, evaluations, best.cost, best.weight);
+  }
+}
+
+template <typename MUTATION, typename CROSSOVER, size_t DIM, typename PRECISION>
+const instrumentation_t &
+IslandModel<MUTATION, CROSSOVER, DIM, PRECISION>::Instrumentation() const {
+  return instrumentation_;
+}
+
+template <typename MUTATION, typename CROSSOVER, size_t DIM, typename PRECISION>
+const std::vector<size_t> &
+IslandModel<MUTATION, CROSSOVER, DIM, PRECISION>::Evaluations() const {
+  return evaluations_;
+}
+
+template <typename MUTATION, typename CROSSOVER, size_t DIM, typename PRECISION>
+void IslandModel<MUTATION, CROSSOVER, DIM, PRECISION>::BuildQueues(size_t dim) {
+  const auto islands = config_.islands;
+  const migrant_structure prototype{0.0, std::vector<double>(dim)};
+  // two emigrations worth of slack before migrants get dropped
+  const auto capacity = 2 * config_.migrants;
+
+  queues_.clear();
+  queues_.resize(islands * islands);
+  for (size_t from = 0; from < islands; ++from) {
+    for (size_t to = 0; to < islands; ++to) {
+      const auto linked =
+          from != to && (config_.topology == MigrationTopology::kFullyConnected ||
+                         to == (from + 1) % islands);
+      if (linked) {
+        queues_[from * islands + to] =
+            std::make_unique<SpscQueue<migrant_structure>>(capacity,
+                                                           prototype);
+      }
+    }
+  }
+}
+
+template <typename MUTATION, typename CROSSOVER, size_t DIM, typename PRECISION>
+template <typename FUN>
+void IslandModel<MUTATION, CROSSOVER, DIM, PRECISION>::RunIsland(
+    size_t island, const pop_t &population, size_t iterations, FUN fun,
+    std::atomic<bool> &stop) {
+  auto &engine = engines_[island];
+  auto &history = histories_[island];
+  auto &evaluations = island_evaluations_[island];
+  auto &progress = progress_[island];
+  migrant_structure migrant{0.0, std::vector<double>(population.dim)};
+
+  engine.Init(population, fun);
+  {
+    const std::lock_guard lock(log_mutex_);
+    engine.ReserveRecords(history, iterations);
+    evaluations.resize(history.size());
+  }
+
+  size_t g = 0;
+  while (engine.Evaluations() < iterations) {
+    if (stop.load(std::memory_order_relaxed)) {
+      const std::lock_guard lock(log_mutex_);
+      history.resize(g);
+      evaluations.resize(g);
+      return;
+    }
+    if (g == history.size()) {
+      // a shrinking population ran out of records, Flush may be reading
+      const std::lock_guard lock(log_mutex_);
+      engine.ReserveRecords(history, iterations);
+      evaluations.resize(history.size());
+    }
+
+    engine.Step(fun);
+    if (engine.Generation() % config_.migration_interval == 0) {
+      Emigrate(island, engine, migrant);
+    }
+    Immigrate(island, engine, migrant);
+    engine.RecordBest(history[g]);
+    evaluations[g++] = engine.Evaluations();
+    progress.generations.store(g, std::memory_order_release);
+
+    // whoever holds the lock appends for everybody, the rest moves on
+    if (log_) {
+      const std::unique_lock lock(log_mutex_, std::try_to_lock);
+      if (lock.owns_lock()) Flush();
+    }
+  }
+}
+
+template <typename MUTATION, typename CROSSOVER, size_t DIM, typename PRECISION>
+void IslandModel<MUTATION, CROSSOVER, DIM, PRECISION>::Emigrate(
+    size_t island, const engine_t &engine, migrant_structure &migrant) {
+  const auto &population = engine.Population();
+  const auto islands = config_.islands;
+
+  // the best `migrants` individuals, found by repeated partial selection
+  // over their costs so the steady state stays allocation free
+  auto last_cost = -std::numeric_limits<double>::infinity();
+  auto last_idx = population.size;
+  for (size_t m = 0; m < std::min(config_.migrants, population.size); ++m) {
+    auto idx = population.size;
+    for (size_t j = 0; j < population.size; ++j) {
+      const auto cost = population.costs[j];
+      const auto after_last =
+          cost > last_cost || (cost == last_cost && j > last_idx);
+      if (after_last &&
+          (idx == population.size || cost < population.costs[idx])) {
+        idx = j;
+      }
+    }
+    if (idx == population.size) break;
+
+    migrant.cost = population.costs[idx];
+    std::ranges::copy(population.Row(idx), migrant.weight.begin());
+    for (size_t to = 0; to < islands; ++to) {
+      if (auto &queue = queues_[island * islands + to]) {
+        queue->TryPush(migrant);
+      }
+    }
+    last_cost = population.costs[idx];
+    last_idx = idx;
+  }
+}
+
+template <typename MUTATION, typename CROSSOVER, size_t DIM, typename PRECISION>
+void IslandModel<MUTATION, CROSSOVER, DIM, PRECISION>::Immigrate(
+    size_t island, engine_t &engine, migrant_structure &migrant) {
+  const auto islands = config_.islands;
+  for (size_t from = 0; from < islands; ++from) {
+    auto &queue = queues_[from * islands + island];
+    if (!queue) continue;
+    while (queue->TryPop(migrant)) {
+      engine.Immigrate(migrant.weight, migrant.cost);
+    }
+  }
+}
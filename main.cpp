@@ -1,4 +1,7 @@
 #include <algorithm>
+#include <cstdint>
+#include <filesystem>
+#include <format>
 #include <fstream>
 #include <iostream>
 #include <memory>
@@ -6,11 +9,16 @@
 #include <string>
 #include <vector>
 
+#include "convergence_log.h"
 #include "diff_evo.h"
-#include "matplotlibcpp.h"
+#include "experiment_runner.h"
 #include "test_functions.h"
 
+#ifdef DIFF_EVO_PLOTTING
+#include "matplotlibcpp.h"
+
 namespace plt = matplotlibcpp;
+#endif
 
 #define F (0.5)
 #define CR (0.8)
@@ -26,7 +34,9 @@ void WriteMarkdownHeader(const std::string &filename,
   }
 
   file << "## " << func_name << "\n\n";
+#ifdef DIFF_EVO_PLOTTING
   file << "![](" << func_name << "_comparison.png)\n\n";
+#endif
   file << "| Run | Algorithm | Best Cost | Worst Cost | Best Weights | Worst "
           "Weights | Final Cost | Final Weights |\n";
   file << "|-----|-----------|-----------|------------|--------------|---------"
@@ -37,29 +47,33 @@ void WriteMarkdownHeader(const std::string &filename,
 
 void WriteMarkdownSummary(const std::string &filename, int run,
                           const std::string &algo_name,
-                          const std::vector<de_t> &results) {
+                          const ConvergenceLog &results) {
   std::ofstream file(filename, std::ios::app);
   if (!file.is_open()) {
     std::cerr << "Unable to open file: " << filename << std::endl;
     return;
   }
+  if (results.Size() == 0) return;
 
-  auto best_it = std::ranges::min_element(
-      results, [](const de_t &a, const de_t &b) { return a.cost < b.cost; });
-  auto worst_it = std::ranges::max_element(
-      results, [](const de_t &a, const de_t &b) { return a.cost < b.cost; });
+  size_t best = 0;
+  size_t worst = 0;
+  for (size_t i = 1; i < results.Size(); ++i) {
+    if (results.Cost(i) < results.Cost(best)) best = i;
+    if (results.Cost(i) > results.Cost(worst)) worst = i;
+  }
+  const auto last = results.Size() - 1;
 
-  file << "| " << run + 1 << " | " << algo_name << " | " << best_it->cost
-       << " | " << worst_it->cost << " | ";
-  for (const auto &weight : best_it->weight) {
+  file << "| " << run + 1 << " | " << algo_name << " | " << results.Cost(best)
+       << " | " << results.Cost(worst) << " | ";
+  for (const auto &weight : results.Genome(best)) {
     file << weight << " ";
   }
   file << "| ";
-  for (const auto &weight : worst_it->weight) {
+  for (const auto &weight : results.Genome(worst)) {
     file << weight << " ";
   }
-  file << "| " << results.back().cost << " | ";
-  for (const auto &weight : results.back().weight) {
+  file << "| " << results.Cost(last) << " | ";
+  for (const auto &weight : results.Genome(last)) {
     file << weight << " ";
   }
   file << "|\n";
@@ -67,33 +81,123 @@ void WriteMarkdownSummary(const std::string &filename, int run,
   file.close();
 }
 
+#ifdef DIFF_EVO_PLOTTING
+// Averages the runs at each evaluation count of `grid`, a run counting with
+// its last record at or before it. L-SHADE shrinks its population and runs
+// more generations on the same budget, evaluations keep it comparable.
 void PlotAverageResults(const std::string &label,
-                        const std::vector<std::vector<de_t>> &all_results) {
+                        const std::vector<ConvergenceLog> &all_results,
+                        const std::vector<double> &grid) {
   std::vector<double> x;
-  std::vector<double> avg_y(all_results[0].size(), 0.0);
-
-  for (size_t run = 0; run < all_results.size(); ++run) {
-    for (size_t i = 0; i < all_results[run].size(); ++i) {
-      avg_y[i] += all_results[run][i].cost;
+  std::vector<double> avg_y;
+  std::vector<size_t> record(all_results.size(), 0);
+
+  for (const double evaluations : grid) {
+    double sum = 0.0;
+    bool reached = true;
+    for (size_t run = 0; run < all_results.size() && reached; ++run) {
+      const auto &results = all_results[run];
+      auto &i = record[run];
+      while (i + 1 < results.Size() &&
+             results.Evaluations(i + 1) <= evaluations) {
+        ++i;
+      }
+      // no run is drawn before its first generation
+      reached = results.Size() > 0 && results.Evaluations(i) <= evaluations;
+      if (reached) sum += results.Cost(i);
     }
-  }
-
-  for (double &value : avg_y) {
-    value /= all_results.size();
-  }
-
-  for (size_t i = 0; i < avg_y.size(); ++i) {
-    x.push_back(i);
+    if (!reached) continue;
+    x.push_back(evaluations);
+    avg_y.push_back(sum / all_results.size());
   }
 
   plt::named_plot(label, x, avg_y);
 }
+#endif
+
+struct function_structure {
+  std::string name;
+  std::string title;
+  void (*function)(de_t *);
+};
+
+struct algorithm_structure {
+  std::string name;
+  Strategy strategy;
+  double cross_rate;
+  // Jobs are added batch by batch and seeded by their position, an algorithm
+  // added in a new batch leaves the seeds of the earlier ones alone.
+  int batch = 0;
+};
 
 int main() {
-  auto diff_evo = std::make_unique<DiffEvo>();
-  diff_evo->GenerateInitPopulation(3, 200);
-  diff_evo->AddMinLimits(-5.0);
-  diff_evo->AddMaxLimits(5.0);
+  constexpr int RUNS = 10;
+  constexpr uint64_t SEED = 2024;
+  constexpr size_t POPULATION = 200;
+  constexpr size_t ITERATIONS = 10000;
+  const std::string LOG_DIR = "logs";
+
+  const std::vector<function_structure> functions = {
+      {"Schefel_Function", "Schefel Function", test_functions::Schefel},
+      {"Sphere_Function", "Sphere Function", test_functions::Sphare},
+      {"Rosenbrock_Function", "Rosenbrock Function",
+       test_functions::Rosenbrock},
+  };
+  const std::vector<algorithm_structure> algorithms = {
+      {"Rand/1", Strategy::kRand1, CR},
+      {"Best/1", Strategy::kBest1, CR},
+      {"jDE", Strategy::kJde, JCR},
+      {"L-SHADE", Strategy::kLshade, CR, 1},
+  };
+
+  // job (f, a, run) always gets the same seed, whatever the thread count
+  ExperimentRunner runner;
+  std::vector<size_t> first_job(functions.size() * algorithms.size());
+  const auto batches =
+      std::ranges::max(algorithms, {}, &algorithm_structure::batch).batch;
+  for (int batch = 0; batch <= batches; ++batch) {
+    for (size_t f = 0; f < functions.size(); ++f) {
+      for (size_t a = 0; a < algorithms.size(); ++a) {
+        const auto &function = functions[f];
+        const auto &algorithm = algorithms[a];
+        if (algorithm.batch != batch) continue;
+        first_job[f * algorithms.size() + a] = runner.Jobs().size();
+        for (int run = 0; run < RUNS; ++run) {
+          experiment_job_t job;
+          job.name = function.name;
+          job.function = function.function;
+          job.strategy = algorithm.strategy;
+          job.dimensions = 3;
+          job.population_size = POPULATION;
+          job.iterations = ITERATIONS;
+          job.min_limit = -5.0;
+          job.max_limit = 5.0;
+          job.mutation_rate = F;
+          job.cross_rate = algorithm.cross_rate;
+          job.tau1 = TAU;
+          job.tau2 = TAU;
+          job.seed = SEED + runner.Jobs().size();
+          job.log_path = std::format("{}/{}_{}_{}.bin", LOG_DIR, function.name,
+                                     static_cast<int>(algorithm.strategy), run);
+          job.log_genome = true;
+          runner.Add(std::move(job));
+        }
+      }
+    }
+  }
+
+  std::filesystem::create_directories(LOG_DIR);
+  runner.Run();
+
+  // runs are read back from their memory mapped logs, never loaded whole
+  auto runs_of = [&](size_t f, size_t a) {
+    std::vector<ConvergenceLog> logs;
+    for (int run = 0; run < RUNS; ++run) {
+      logs.emplace_back(
+          runner.Jobs()[first_job[f * algorithms.size() + a] + run].log_path);
+    }
+    return logs;
+  };
 
   std::ofstream md_file("results.md");
   if (md_file.is_open()) {
@@ -101,113 +205,38 @@ int main() {
     md_file.close();
   }
 
-  constexpr int RUNS = 10;
-
-  std::vector<std::vector<de_t>> all_schefel_rand1(RUNS);
-  std::vector<std::vector<de_t>> all_sphare_rand1(RUNS);
-  std::vector<std::vector<de_t>> all_rosenbrock_rand1(RUNS);
-  std::vector<std::vector<de_t>> all_schefel_best1(RUNS);
-  std::vector<std::vector<de_t>> all_sphare_best1(RUNS);
-  std::vector<std::vector<de_t>> all_rosenbrock_best1(RUNS);
-  std::vector<std::vector<de_t>> all_schefel_jde(RUNS);
-  std::vector<std::vector<de_t>> all_sphare_jde(RUNS);
-  std::vector<std::vector<de_t>> all_rosenbrock_jde(RUNS);
-
-  for (int run = 0; run < RUNS; ++run) {
-    // Schefel Function
-    all_schefel_rand1[run] =
-        diff_evo->Rand1(10000, F, CR, test_functions::Schefel);
-    all_schefel_best1[run] =
-        diff_evo->Best1(10000, F, CR, test_functions::Schefel);
-    all_schefel_jde[run] =
-        diff_evo->jDE(10000, F, JCR, TAU, TAU, test_functions::Schefel);
-
-    // Sphere Function
-    all_sphare_rand1[run] =
-        diff_evo->Rand1(10000, F, CR, test_functions::Sphare);
-    all_sphare_best1[run] =
-        diff_evo->Best1(10000, F, CR, test_functions::Sphare);
-    all_sphare_jde[run] =
-        diff_evo->jDE(10000, F, JCR, TAU, TAU, test_functions::Sphare);
-
-    // Rosenbrock Function
-    all_rosenbrock_rand1[run] =
-        diff_evo->Rand1(10000, F, CR, test_functions::Rosenbrock);
-    all_rosenbrock_best1[run] =
-        diff_evo->Best1(10000, F, CR, test_functions::Rosenbrock);
-    all_rosenbrock_jde[run] =
-        diff_evo->jDE(10000, F, JCR, TAU, TAU, test_functions::Rosenbrock);
-  }
-
-  WriteMarkdownHeader("results.md", "Schefel_Function");
-  for (int run = 0; run < RUNS; ++run) {
-    WriteMarkdownSummary("results.md", run, "Rand/1", all_schefel_rand1[run]);
-  }
-  for (int run = 0; run < RUNS; ++run) {
-    WriteMarkdownSummary("results.md", run, "Best/1", all_schefel_best1[run]);
-  }
-  for (int run = 0; run < RUNS; ++run) {
-    WriteMarkdownSummary("results.md", run, "jDE", all_schefel_jde[run]);
-  }
-
-  WriteMarkdownHeader("results.md", "Sphere_Function");
-  for (int run = 0; run < RUNS; ++run) {
-    WriteMarkdownSummary("results.md", run, "Rand/1", all_sphare_rand1[run]);
-  }
-  for (int run = 0; run < RUNS; ++run) {
-    WriteMarkdownSummary("results.md", run, "Best/1", all_sphare_best1[run]);
-  }
-  for (int run = 0; run < RUNS; ++run) {
-    WriteMarkdownSummary("results.md", run, "jDE", all_sphare_jde[run]);
+  for (size_t f = 0; f < functions.size(); ++f) {
+    WriteMarkdownHeader("results.md", functions[f].name);
+    for (size_t a = 0; a < algorithms.size(); ++a) {
+      const auto runs = runs_of(f, a);
+      for (int run = 0; run < RUNS; ++run) {
+        WriteMarkdownSummary("results.md", run, algorithms[a].name,
+                             runs[run]);
+      }
+    }
   }
 
-  WriteMarkdownHeader("results.md", "Rosenbrock_Function");
-  for (int run = 0; run < RUNS; ++run) {
-    WriteMarkdownSummary("results.md", run, "Rand/1",
-                         all_rosenbrock_rand1[run]);
-  }
-  for (int run = 0; run < RUNS; ++run) {
-    WriteMarkdownSummary("results.md", run, "Best/1",
-                         all_rosenbrock_best1[run]);
-  }
-  for (int run = 0; run < RUNS; ++run) {
-    WriteMarkdownSummary("results.md", run, "jDE", all_rosenbrock_jde[run]);
+#ifdef DIFF_EVO_PLOTTING
+  // every algorithm is averaged on the same evaluation counts
+  std::vector<double> grid;
+  for (size_t evaluations = POPULATION / 2; evaluations <= ITERATIONS;
+       evaluations += POPULATION / 2) {
+    grid.push_back(static_cast<double>(evaluations));
   }
 
-  // Schefel Function
-  plt::figure();
-  PlotAverageResults("Rand/1", all_schefel_rand1);
-  PlotAverageResults("Best/1", all_schefel_best1);
-  PlotAverageResults("jDE", all_schefel_jde);
-  plt::title("Schefel Function - Comparison of Algorithms");
-  plt::xlabel("Iteration");
-  plt::ylabel("Cost");
-  plt::legend();
-  plt::save("Schefel_Function_comparison.png");
-  plt::clf();
-
-  // Sphere Function
-  plt::figure();
-  PlotAverageResults("Rand/1", all_sphare_rand1);
-  PlotAverageResults("Best/1", all_sphare_best1);
-  PlotAverageResults("jDE", all_sphare_jde);
-  plt::title("Sphere Function - Comparison of Algorithms");
-  plt::xlabel("Iteration");
-  plt::ylabel("Cost");
-  plt::legend();
-  plt::save("Sphere_Function_comparison.png");
-  plt::clf();
-
-  // Rosenbrock Function
-  plt::figure();
-  PlotAverageResults("Rand/1", all_rosenbrock_rand1);
-  PlotAverageResults("Best/1", all_rosenbrock_best1);
-  PlotAverageResults("jDE", all_rosenbrock_jde);
-  plt::title("Rosenbrock Function - Comparison of Algorithms");
-  plt::xlabel("Iteration");
-  plt::ylabel("Cost");
-  plt::legend();
-  plt::save("Rosenbrock_Function_comparison.png");
+  for (size_t f = 0; f < functions.size(); ++f) {
+    plt::figure();
+    for (size_t a = 0; a < algorithms.size(); ++a) {
+      PlotAverageResults(algorithms[a].name, runs_of(f, a), grid);
+    }
+    plt::title(functions[f].title + " - Comparison of Algorithms");
+    plt::xlabel("Evaluations");
+    plt::ylabel("Cost");
+    plt::legend();
+    plt::save(functions[f].name + "_comparison.png");
+    plt::clf();
+  }
+#endif
 
   return 0;
 }
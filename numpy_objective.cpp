@@ -0,0 +1,145 @@
+/*
+ * Created by kureii on 11/15/24.
+ */
+
+#include "numpy_objective.h"
+
+#define NPY_NO_DEPRECATED_API NPY_1_7_API_VERSION
+#include <numpy/arrayobject.h>
+
+#include <algorithm>
+#include <format>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+
+namespace {
+
+class GilLock {
+ public:
+  GilLock() : state_(PyGILState_Ensure()) {}
+  ~GilLock() { PyGILState_Release(state_); }
+
+  GilLock(const GilLock &) = delete;
+  GilLock &operator=(const GilLock &) = delete;
+
+ private:
+  PyGILState_STATE state_;
+};
+
+struct PyDecref {
+  void operator()(PyObject *object) const { Py_XDECREF(object); }
+};
+
+using py_ref_t = std::unique_ptr<PyObject, PyDecref>;
+
+// Message of the pending Python exception, which is cleared.
+std::string PythonError() {
+  PyObject *type = nullptr;
+  PyObject *value = nullptr;
+  PyObject *traceback = nullptr;
+  PyErr_Fetch(&type, &value, &traceback);
+  const py_ref_t type_ref(type);
+  const py_ref_t value_ref(value);
+  const py_ref_t traceback_ref(traceback);
+
+  if (value == nullptr) return "unknown Python error";
+  const py_ref_t text(PyObject_Str(value));
+  const char *message = text ? PyUnicode_AsUTF8(text.get()) : nullptr;
+  if (message == nullptr) {
+    PyErr_Clear();
+    return "unprintable Python error";
+  }
+  return message;
+}
+
+template <typename T>
+constexpr int NpyType() {
+  return std::is_same_v<T, float> ? NPY_FLOAT32 : NPY_FLOAT64;
+}
+
+}  // namespace
+
+NumpyObjective::NumpyObjective(PyObject *callable, bool out_parameter)
+    : out_parameter_(out_parameter) {
+  if (callable == nullptr || !PyCallable_Check(callable)) {
+    throw std::invalid_argument("NumpyObjective needs a callable");
+  }
+  // the C API table of NumPy is loaded once, by the first objective
+  if (PyArray_API == nullptr && _import_array() < 0) {
+    throw std::runtime_error(
+        std::format("cannot import NumPy: {}", PythonError()));
+  }
+
+  Py_INCREF(callable);
+  callable_.reset(callable, [](PyObject *object) {
+    GilLock lock;
+    Py_DECREF(object);
+  });
+}
+
+template <typename SCALAR, typename COST>
+void NumpyObjective::operator()(population_view_structure<SCALAR> population,
+                                std::span<COST> costs) const {
+  if (population.size == 0) return;
+  GilLock lock;
+
+  npy_intp shape[2] = {static_cast<npy_intp>(population.size),
+                       static_cast<npy_intp>(population.dim)};
+  // read-only flags, NumPy never writes through the cast away const
+  const py_ref_t weights(PyArray_New(
+      &PyArray_Type, 2, shape, NpyType<SCALAR>(), nullptr,
+      const_cast<SCALAR *>(population.weights), 0, NPY_ARRAY_CARRAY_RO,
+      nullptr));
+  if (!weights) {
+    throw std::runtime_error(
+        std::format("cannot wrap the population: {}", PythonError()));
+  }
+
+  if (out_parameter_) {
+    const py_ref_t out(PyArray_New(&PyArray_Type, 1, shape, NpyType<COST>(),
+                                   nullptr, costs.data(), 0,
+                                   NPY_ARRAY_CARRAY, nullptr));
+    if (!out) {
+      throw std::runtime_error(
+          std::format("cannot wrap the costs: {}", PythonError()));
+    }
+    const py_ref_t result(PyObject_CallFunctionObjArgs(
+        callable_.get(), weights.get(), out.get(), nullptr));
+    if (!result) {
+      throw std::runtime_error(
+          std::format("objective failed: {}", PythonError()));
+    }
+    return;
+  }
+
+  const py_ref_t result(PyObject_CallOneArg(callable_.get(), weights.get()));
+  if (!result) {
+    throw std::runtime_error(
+        std::format("objective failed: {}", PythonError()));
+  }
+  // no copy when the objective already returns contiguous COST
+  const py_ref_t array(PyArray_FROMANY(result.get(), NpyType<COST>(), 0, 0,
+                                       NPY_ARRAY_IN_ARRAY |
+                                           NPY_ARRAY_FORCECAST));
+  if (!array) {
+    throw std::runtime_error(
+        std::format("objective returned no costs: {}", PythonError()));
+  }
+  const auto returned = static_cast<size_t>(
+      PyArray_SIZE(reinterpret_cast<PyArrayObject *>(array.get())));
+  if (returned != population.size) {
+    throw std::runtime_error(
+        std::format("objective returned {} costs for {} individuals",
+                    returned, population.size));
+  }
+  const auto *data = static_cast<const COST *>(
+      PyArray_DATA(reinterpret_cast<PyArrayObject *>(array.get())));
+  std::copy_n(data, population.size, costs.begin());
+}
+
+template void NumpyObjective::operator()(pop_view_t, std::span<double>) const;
+template void NumpyObjective::operator()(float_pop_view_t,
+                                         std::span<float>) const;
+template void NumpyObjective::operator()(float_pop_view_t,
+                                         std::span<double>) const;
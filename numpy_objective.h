@@ -0,0 +1,46 @@
+/*
+ * Created by kureii on 11/15/24.
+ */
+
+#pragma once
+
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+
+#include <memory>
+#include <span>
+
+#include "structures.h"
+
+// Batch objective backed by a Python callable working on whole NumPy arrays.
+// Each call hands the block of individuals to Python as a read-only
+// (size, dim) array that views the engine's population without a copy,
+// float64 or float32 after the gene type, so a vectorized objective like
+//
+//   lambda x: (x * x).sum(axis=1)
+//
+// runs once per block instead of once per individual. The callable returns
+// the costs as anything NumPy turns into `size` numbers, or, with
+// `out_parameter`, is called as f(x, out) and writes them into `out`, a view
+// of the engine's cost buffer. Neither array may be kept past the call.
+//
+// Every call takes the GIL, so the threads of a run take turns in Python.
+// The interpreter has to stay initialized while the objective exists, and a
+// thread holding the GIL has to release it (Py_BEGIN_ALLOW_THREADS) while it
+// waits for a run on more than one thread. Python exceptions are rethrown as
+// std::runtime_error.
+class NumpyObjective {
+ public:
+  // Needs the GIL, keeps a reference to `callable` shared by all copies.
+  explicit NumpyObjective(PyObject *callable, bool out_parameter = false);
+
+  // Defined for double genes and costs, float genes and costs, and float
+  // genes with double costs.
+  template <typename SCALAR, typename COST>
+  void operator()(population_view_structure<SCALAR> population,
+                  std::span<COST> costs) const;
+
+ private:
+  std::shared_ptr<PyObject> callable_;
+  bool out_parameter_;
+};
@@ -0,0 +1,27 @@
+/*
+ * Created by kureii on 11/15/24.
+ */
+
+#include "parallel_runner.h"
+
+#include <stdexcept>
+
+void ParallelRunner::SetThreads(size_t threads) {
+  executor_ = nullptr;
+  executor_tasks_ = 0;
+  pool_ = threads > 1 ? std::make_unique<ThreadPool>(threads) : nullptr;
+}
+
+void ParallelRunner::SetExecutor(executor_t executor, size_t tasks) {
+  if (!executor || tasks == 0) {
+    throw std::invalid_argument("executor must be callable with tasks > 0");
+  }
+  pool_ = nullptr;
+  executor_ = std::move(executor);
+  executor_tasks_ = tasks;
+}
+
+size_t ParallelRunner::Workers() const {
+  if (executor_) return executor_tasks_;
+  return pool_ ? pool_->Size() : 1;
+}
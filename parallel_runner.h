@@ -0,0 +1,56 @@
+/*
+ * Created by kureii on 11/15/24.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <type_traits>
+
+#include "thread_pool.h"
+
+// Runs task(i) for every i in [0, tasks) and returns once all of them are done.
+using executor_t =
+    std::function<void(size_t tasks, const std::function<void(size_t)> &task)>;
+
+// Decides how a generation is split up: on the calling thread, on an owned
+// ThreadPool or through a user supplied executor.
+class ParallelRunner {
+ public:
+  // 0 or 1 keeps everything on the calling thread.
+  void SetThreads(size_t threads);
+  void SetExecutor(executor_t executor, size_t tasks);
+
+  // Number of chunks ForEachChunk splits a range into.
+  [[nodiscard]] size_t Workers() const;
+
+  // Calls task(chunk, begin, end) for every chunk of [0, count) and returns
+  // once all of them are done.
+  template <typename TASK>
+  void ForEachChunk(size_t count, TASK &&task) {
+    if (pool_) {
+      pool_->ParallelFor(count, task);
+    } else if (executor_) {
+      // a single captured pointer keeps std::function in its small buffer
+      struct {
+        size_t count;
+        size_t tasks;
+        std::remove_reference_t<TASK> *task;
+      } ctx{count, executor_tasks_, &task};
+      executor_(ctx.tasks, [&ctx](size_t chunk) {
+        const auto begin = ctx.count * chunk / ctx.tasks;
+        const auto end = ctx.count * (chunk + 1) / ctx.tasks;
+        if (begin < end) (*ctx.task)(chunk, begin, end);
+      });
+    } else {
+      task(0, 0, count);
+    }
+  }
+
+ private:
+  std::unique_ptr<ThreadPool> pool_;
+  executor_t executor_;
+  size_t executor_tasks_ = 0;
+};
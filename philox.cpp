@@ -0,0 +1,236 @@
+/*
+ * Created by kureii on 11/15/24.
+ */
+
+#include "philox.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define PHILOX_X86
+#endif
+
+namespace {
+
+constexpr uint32_t kMul0 = 0xD2511F53;
+constexpr uint32_t kMul1 = 0xCD9E8D57;
+constexpr uint32_t kWeyl0 = 0x9E3779B9;
+constexpr uint32_t kWeyl1 = 0xBB67AE85;
+constexpr int kRounds = 10;
+
+// Scatters lane l of the four counter words into block b of its stream.
+void StoreLanes(const uint32_t *c0, const uint32_t *c1, const uint32_t *c2,
+                const uint32_t *c3, size_t count, size_t b, size_t blocks,
+                uint32_t *out) {
+  for (size_t l = 0; l < count; ++l) {
+    auto *block = out + (l * blocks + b) * 4;
+    block[0] = c0[l];
+    block[1] = c1[l];
+    block[2] = c2[l];
+    block[3] = c3[l];
+  }
+}
+
+size_t FillScalar(Philox4x32::key_t key, uint32_t run, uint32_t generation,
+                  uint32_t first, size_t count, size_t blocks,
+                  uint32_t *out) {
+  for (size_t l = 0; l < count; ++l) {
+    for (size_t b = 0; b < blocks; ++b) {
+      const auto block = Philox4x32::Block(
+          {static_cast<uint32_t>(b), first + static_cast<uint32_t>(l),
+           generation, run},
+          key);
+      std::ranges::copy(block, out + (l * blocks + b) * 4);
+    }
+  }
+  return count;
+}
+
+#ifdef PHILOX_X86
+
+// The vector kernels run one individual per 32 bit lane. mul_epu32 only
+// multiplies the even lanes, so the odd ones are shifted down and multiplied
+// separately, then both halves are blended back into hi and lo words.
+
+__attribute__((target("avx2"))) inline void MulHiLo(__m256i x, __m256i m,
+                                                    __m256i &hi, __m256i &lo) {
+  const auto even = _mm256_mul_epu32(x, m);
+  const auto odd = _mm256_mul_epu32(_mm256_srli_epi64(x, 32), m);
+  lo = _mm256_blend_epi32(even, _mm256_slli_epi64(odd, 32), 0xAA);
+  hi = _mm256_blend_epi32(_mm256_srli_epi64(even, 32), odd, 0xAA);
+}
+
+__attribute__((target("avx2"))) size_t FillAvx2(
+    Philox4x32::key_t key, uint32_t run, uint32_t generation, uint32_t first,
+    size_t count, size_t blocks, uint32_t *out) {
+  constexpr size_t kLanes = 8;
+  const auto mul0 = _mm256_set1_epi32(static_cast<int>(kMul0));
+  const auto mul1 = _mm256_set1_epi32(static_cast<int>(kMul1));
+  const auto lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+  alignas(32) uint32_t w0[kLanes], w1[kLanes], w2[kLanes], w3[kLanes];
+
+  size_t done = 0;
+  for (; done + kLanes <= count; done += kLanes) {
+    const auto individuals = _mm256_add_epi32(
+        _mm256_set1_epi32(static_cast<int>(first + done)), lanes);
+    for (size_t b = 0; b < blocks; ++b) {
+      auto c0 = _mm256_set1_epi32(static_cast<int>(b));
+      auto c1 = individuals;
+      auto c2 = _mm256_set1_epi32(static_cast<int>(generation));
+      auto c3 = _mm256_set1_epi32(static_cast<int>(run));
+      auto k0 = key[0];
+      auto k1 = key[1];
+      for (int r = 0; r < kRounds; ++r) {
+        __m256i hi0, lo0, hi1, lo1;
+        MulHiLo(c0, mul0, hi0, lo0);
+        MulHiLo(c2, mul1, hi1, lo1);
+        c0 = _mm256_xor_si256(
+            _mm256_xor_si256(hi1, c1), _mm256_set1_epi32(static_cast<int>(k0)));
+        c1 = lo1;
+        c2 = _mm256_xor_si256(
+            _mm256_xor_si256(hi0, c3), _mm256_set1_epi32(static_cast<int>(k1)));
+        c3 = lo0;
+        k0 += kWeyl0;
+        k1 += kWeyl1;
+      }
+      _mm256_store_si256(reinterpret_cast<__m256i *>(w0), c0);
+      _mm256_store_si256(reinterpret_cast<__m256i *>(w1), c1);
+      _mm256_store_si256(reinterpret_cast<__m256i *>(w2), c2);
+      _mm256_store_si256(reinterpret_cast<__m256i *>(w3), c3);
+      StoreLanes(w0, w1, w2, w3, kLanes, b, blocks, out + done * blocks * 4);
+    }
+  }
+  return done;
+}
+
+__attribute__((target("avx512f"))) inline void MulHiLo(__m512i x, __m512i m,
+                                                       __m512i &hi,
+                                                       __m512i &lo) {
+  const auto even = _mm512_mul_epu32(x, m);
+  const auto odd = _mm512_mul_epu32(_mm512_srli_epi64(x, 32), m);
+  lo = _mm512_mask_blend_epi32(0xAAAA, even, _mm512_slli_epi64(odd, 32));
+  hi = _mm512_mask_blend_epi32(0xAAAA, _mm512_srli_epi64(even, 32), odd);
+}
+
+__attribute__((target("avx512f"))) size_t FillAvx512(
+    Philox4x32::key_t key, uint32_t run, uint32_t generation, uint32_t first,
+    size_t count, size_t blocks, uint32_t *out) {
+  constexpr size_t kLanes = 16;
+  const auto mul0 = _mm512_set1_epi32(static_cast<int>(kMul0));
+  const auto mul1 = _mm512_set1_epi32(static_cast<int>(kMul1));
+  const auto lanes = _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11,
+                                       12, 13, 14, 15);
+  alignas(64) uint32_t w0[kLanes], w1[kLanes], w2[kLanes], w3[kLanes];
+
+  size_t done = 0;
+  for (; done + kLanes <= count; done += kLanes) {
+    const auto individuals = _mm512_add_epi32(
+        _mm512_set1_epi32(static_cast<int>(first + done)), lanes);
+    for (size_t b = 0; b < blocks; ++b) {
+      auto c0 = _mm512_set1_epi32(static_cast<int>(b));
+      auto c1 = individuals;
+      auto c2 = _mm512_set1_epi32(static_cast<int>(generation));
+      auto c3 = _mm512_set1_epi32(static_cast<int>(run));
+      auto k0 = key[0];
+      auto k1 = key[1];
+      for (int r = 0; r < kRounds; ++r) {
+        __m512i hi0, lo0, hi1, lo1;
+        MulHiLo(c0, mul0, hi0, lo0);
+        MulHiLo(c2, mul1, hi1, lo1);
+        c0 = _mm512_xor_si512(
+            _mm512_xor_si512(hi1, c1), _mm512_set1_epi32(static_cast<int>(k0)));
+        c1 = lo1;
+        c2 = _mm512_xor_si512(
+            _mm512_xor_si512(hi0, c3), _mm512_set1_epi32(static_cast<int>(k1)));
+        c3 = lo0;
+        k0 += kWeyl0;
+        k1 += kWeyl1;
+      }
+      _mm512_store_si512(w0, c0);
+      _mm512_store_si512(w1, c1);
+      _mm512_store_si512(w2, c2);
+      _mm512_store_si512(w3, c3);
+      StoreLanes(w0, w1, w2, w3, kLanes, b, blocks, out + done * blocks * 4);
+    }
+  }
+  return done;
+}
+
+#endif
+
+}  // namespace
+
+Philox4x32::Philox4x32(uint64_t seed, uint32_t run, uint32_t generation,
+                       uint32_t individual, uint32_t first_block)
+    : key_{static_cast<uint32_t>(seed), static_cast<uint32_t>(seed >> 32)},
+      counter_{first_block, individual, generation, run} {}
+
+Philox4x32::result_type Philox4x32::operator()() {
+  if (used_ == 4) {
+    block_ = Block(counter_, key_);
+    ++counter_[0];
+    used_ = 0;
+  }
+  return block_[used_++];
+}
+
+Philox4x32::counter_t Philox4x32::Block(counter_t counter, key_t key) {
+  for (int r = 0; r < kRounds; ++r) {
+    const auto p0 = static_cast<uint64_t>(kMul0) * counter[0];
+    const auto p1 = static_cast<uint64_t>(kMul1) * counter[2];
+    counter = {static_cast<uint32_t>(p1 >> 32) ^ counter[1] ^ key[0],
+               static_cast<uint32_t>(p1),
+               static_cast<uint32_t>(p0 >> 32) ^ counter[3] ^ key[1],
+               static_cast<uint32_t>(p0)};
+    key[0] += kWeyl0;
+    key[1] += kWeyl1;
+  }
+  return counter;
+}
+
+void Philox4x32::FillStreams(uint64_t seed, uint32_t run, uint32_t generation,
+                             uint32_t first, size_t count, size_t blocks,
+                             uint32_t *out) {
+  const key_t key{static_cast<uint32_t>(seed),
+                  static_cast<uint32_t>(seed >> 32)};
+  size_t done = 0;
+#ifdef PHILOX_X86
+  static const auto simd = [] {
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) return 2;
+    if (__builtin_cpu_supports("avx2")) return 1;
+    return 0;
+  }();
+  if (simd == 2) {
+    done = FillAvx512(key, run, generation, first, count, blocks, out);
+  } else if (simd == 1) {
+    done = FillAvx2(key, run, generation, first, count, blocks, out);
+  }
+#endif
+  FillScalar(key, run, generation, first + static_cast<uint32_t>(done),
+             count - done, blocks, out + done * blocks * 4);
+}
+
+Philox4x32::BufferedStream::BufferedStream(const uint32_t *words,
+                                           size_t blocks, uint64_t seed,
+                                           uint32_t run, uint32_t generation,
+                                           uint32_t individual)
+    : words_(words),
+      blocks_(blocks),
+      tail_(seed, run, generation, individual,
+            static_cast<uint32_t>(blocks)) {}
+
+Philox4x32::BufferedStream::result_type
+Philox4x32::BufferedStream::operator()() {
+  if (head_ < kHeadWords) return words_[head_++];
+  return tail_();
+}
+
+std::span<const uint32_t> Philox4x32::BufferedStream::Bulk(size_t n) const {
+  if (Blocks(n) > blocks_) {
+    throw std::out_of_range("bulk request exceeds the buffered stream");
+  }
+  return {words_ + kHeadWords, n};
+}
@@ -0,0 +1,90 @@
+/*
+ * Created by kureii on 11/15/24.
+ */
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <span>
+
+// Philox4x32-10 counter based generator (Salmon et al., "Parallel random
+// numbers: as easy as 1, 2, 3", SC'11). Output block b of the stream
+// (run, generation, individual) is Philox(key = seed,
+// counter = {b, individual, generation, run}), so any individual of any
+// generation of any run gets its own stream without shared state.
+class Philox4x32 {
+ public:
+  using result_type = uint32_t;
+  using counter_t = std::array<uint32_t, 4>;
+  using key_t = std::array<uint32_t, 2>;
+
+  // Individual indices of the streams for the draws made once per
+  // generation, before the children are built and after they are selected.
+  // No population reaches them.
+  static constexpr uint32_t kGenerationStream =
+      std::numeric_limits<uint32_t>::max();
+  static constexpr uint32_t kSelectionStream = kGenerationStream - 1;
+
+  Philox4x32(uint64_t seed, uint32_t run, uint32_t generation,
+             uint32_t individual, uint32_t first_block = 0);
+
+  static constexpr result_type min() { return 0; }
+  static constexpr result_type max() {
+    return std::numeric_limits<result_type>::max();
+  }
+  result_type operator()();
+
+  static counter_t Block(counter_t counter, key_t key);
+
+  // Writes `blocks` blocks of the streams of individuals
+  // [first, first + count) of one generation, individual first + j gets
+  // out[(j * blocks + b) * 4, (j * blocks + b + 1) * 4). Several individuals
+  // are computed side by side in vector registers where the CPU allows it.
+  static void FillStreams(uint64_t seed, uint32_t run, uint32_t generation,
+                          uint32_t first, size_t count, size_t blocks,
+                          uint32_t *out);
+
+  class BufferedStream;
+
+ private:
+  key_t key_;
+  counter_t counter_;
+  counter_t block_{};
+  size_t used_ = 4;
+};
+
+// Stream of one individual whose first blocks were produced by FillStreams.
+// The first kHeadWords words are handed out by operator(), continuing with
+// plain Philox blocks once they run out. Bulk(n) hands out the n words that
+// follow the head in one piece, for consumers that vectorize over them.
+class Philox4x32::BufferedStream {
+ public:
+  using result_type = uint32_t;
+  static constexpr size_t kHeadBlocks = 2;
+  static constexpr size_t kHeadWords = 4 * kHeadBlocks;
+
+  // Blocks FillStreams has to produce for `bulk_words` bulk words.
+  static constexpr size_t Blocks(size_t bulk_words) {
+    return kHeadBlocks + (bulk_words + 3) / 4;
+  }
+
+  BufferedStream(const uint32_t *words, size_t blocks, uint64_t seed,
+                 uint32_t run, uint32_t generation, uint32_t individual);
+
+  static constexpr result_type min() { return 0; }
+  static constexpr result_type max() {
+    return std::numeric_limits<result_type>::max();
+  }
+  result_type operator()();
+
+  [[nodiscard]] std::span<const uint32_t> Bulk(size_t n) const;
+
+ private:
+  const uint32_t *words_;
+  size_t blocks_;
+  size_t head_ = 0;
+  Philox4x32 tail_;
+};
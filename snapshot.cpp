@@ -0,0 +1,181 @@
+/*
+ * Created by kureii on 11/15/24.
+ */
+
+#include "snapshot.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstring>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <stdexcept>
+#include <utility>
+
+using snapshot::header_structure;
+
+namespace {
+
+void WriteDoubles(std::ofstream &file, std::span<const double> values) {
+  file.write(reinterpret_cast<const char *>(values.data()),
+             static_cast<std::streamsize>(values.size_bytes()));
+}
+
+// Flushes `path`, a file or a directory, from the page cache to the disk.
+void Sync(const std::string &path, int flags) {
+  const auto fd = open(path.c_str(), O_RDONLY | flags);
+  if (fd < 0) {
+    throw std::runtime_error(std::format("Unable to open file: {}", path));
+  }
+  const auto synced = fsync(fd) == 0;
+  close(fd);
+  if (!synced) {
+    throw std::runtime_error(std::format("Unable to sync file: {}", path));
+  }
+}
+
+}  // namespace
+
+void WriteSnapshot(const std::string &path, const snapshot_view_t &snapshot) {
+  if (snapshot.min.size() != snapshot.dim ||
+      snapshot.max.size() != snapshot.dim ||
+      snapshot.costs.size() != snapshot.size ||
+      snapshot.weights.size() != snapshot.size * snapshot.dim) {
+    throw std::invalid_argument("snapshot sizes do not match");
+  }
+
+  const auto temporary = path + ".tmp";
+  {
+    std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+      throw std::runtime_error(
+          std::format("Unable to open file: {}", temporary));
+    }
+
+    header_structure header{};
+    std::memcpy(header.magic, snapshot::kMagic, sizeof(header.magic));
+    header.version = snapshot::kVersion;
+    header.run = snapshot.run;
+    header.seed = snapshot.seed;
+    header.size = snapshot.size;
+    header.dim = snapshot.dim;
+    header.best = snapshot.best;
+    header.generation = snapshot.generation;
+    header.evaluations = snapshot.evaluations;
+    header.state_size = snapshot.state.size();
+    header.strategy = snapshot.strategy;
+    header.gene_bytes = snapshot.gene_bytes;
+    header.cost_bytes = snapshot.cost_bytes;
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+
+    WriteDoubles(file, snapshot.min);
+    WriteDoubles(file, snapshot.max);
+    WriteDoubles(file, snapshot.costs);
+    WriteDoubles(file, snapshot.weights);
+    WriteDoubles(file, snapshot.state);
+
+    file.flush();
+    if (!file) {
+      throw std::runtime_error(
+          std::format("Unable to write file: {}", temporary));
+    }
+  }
+
+  // the data has to be on disk before the rename, or a crash can leave an
+  // empty snapshot under the final name, and the rename itself only lasts
+  // once the directory is synced too
+  Sync(temporary, 0);
+  std::filesystem::rename(temporary, path);
+  const auto directory = std::filesystem::path(path).parent_path();
+  Sync(directory.empty() ? "." : directory.string(), O_DIRECTORY);
+}
+
+Snapshot::Snapshot(const std::string &path) {
+  const auto fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    throw std::runtime_error(std::format("Unable to open file: {}", path));
+  }
+
+  struct stat st {};
+  if (fstat(fd, &st) != 0 ||
+      static_cast<size_t>(st.st_size) < sizeof(header_structure)) {
+    close(fd);
+    throw std::runtime_error(std::format("{} is not a snapshot", path));
+  }
+
+  bytes_ = static_cast<size_t>(st.st_size);
+  auto *mapped = mmap(nullptr, bytes_, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (mapped == MAP_FAILED) {
+    throw std::runtime_error(std::format("Unable to map file: {}", path));
+  }
+  data_ = static_cast<const unsigned char *>(mapped);
+
+  header_structure header{};
+  std::memcpy(&header, data_, sizeof(header));
+  // no count may exceed the file before the body size is summed up
+  const auto limit = bytes_ / sizeof(double);
+  const auto counts_fit =
+      header.dim <= limit && header.size <= limit &&
+      header.state_size <= limit &&
+      (header.dim == 0 || header.size <= limit / header.dim);
+  const auto doubles =
+      counts_fit ? 2 * header.dim + header.size + header.size * header.dim +
+                       header.state_size
+                 : 0;
+  if (std::memcmp(header.magic, snapshot::kMagic, sizeof(header.magic)) != 0 ||
+      header.version != snapshot::kVersion || !counts_fit ||
+      bytes_ != sizeof(header) + doubles * sizeof(double) ||
+      header.best >= header.size) {
+    munmap(const_cast<unsigned char *>(data_), bytes_);
+    throw std::runtime_error(std::format(
+        "{} is not a complete version {} snapshot", path, snapshot::kVersion));
+  }
+
+  const auto *values = reinterpret_cast<const double *>(data_ + sizeof(header));
+  auto take = [&values](size_t count) {
+    const std::span<const double> span(values, count);
+    values += count;
+    return span;
+  };
+  view_.seed = header.seed;
+  view_.run = header.run;
+  view_.size = header.size;
+  view_.dim = header.dim;
+  view_.best = header.best;
+  view_.generation = header.generation;
+  view_.evaluations = header.evaluations;
+  view_.strategy = header.strategy;
+  view_.gene_bytes = header.gene_bytes;
+  view_.cost_bytes = header.cost_bytes;
+  view_.min = take(header.dim);
+  view_.max = take(header.dim);
+  view_.costs = take(header.size);
+  view_.weights = take(header.size * header.dim);
+  view_.state = take(header.state_size);
+}
+
+Snapshot::~Snapshot() {
+  if (data_) munmap(const_cast<unsigned char *>(data_), bytes_);
+}
+
+Snapshot::Snapshot(Snapshot &&other) noexcept
+    : data_(std::exchange(other.data_, nullptr)),
+      bytes_(std::exchange(other.bytes_, 0)),
+      view_(std::exchange(other.view_, {})) {}
+
+Snapshot &Snapshot::operator=(Snapshot &&other) noexcept {
+  if (this != &other) {
+    if (data_) munmap(const_cast<unsigned char *>(data_), bytes_);
+    data_ = std::exchange(other.data_, nullptr);
+    bytes_ = std::exchange(other.bytes_, 0);
+    view_ = std::exchange(other.view_, {});
+  }
+  return *this;
+}
+
+const snapshot_view_t &Snapshot::View() const { return view_; }
@@ -0,0 +1,92 @@
+/*
+ * Created by kureii on 11/15/24.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <string>
+
+// Checkpoint of a DiffEvoEngine between two generations:
+//
+//   header  magic "DESNAPSH", uint32 version, uint32 run, uint64 seed,
+//           uint64 size, uint64 dim, uint64 best, uint64 generation,
+//           uint64 evaluations, uint64 state_size, uint32 strategy,
+//           uint16 gene_bytes, uint16 cost_bytes
+//   body    double min[dim], double max[dim], double costs[size],
+//           double weights[size * dim], double state[state_size]
+//
+// `state` holds whatever the mutation policy adapts during a run (jDE's F
+// and CR). `strategy` is the kSnapshotTag of the mutation policy and the
+// byte counts give the precision, Restore refuses a snapshot of another
+// engine. The RNG needs no state of its own, its streams follow from seed,
+// run and generation. Little endian and 8 byte aligned like the convergence
+// log, so Snapshot maps the file and reads it in place.
+namespace snapshot {
+
+inline constexpr char kMagic[8] = {'D', 'E', 'S', 'N', 'A', 'P', 'S', 'H'};
+inline constexpr uint32_t kVersion = 2;
+
+struct header_structure {
+  char magic[8];
+  uint32_t version;
+  uint32_t run;
+  uint64_t seed;
+  uint64_t size;
+  uint64_t dim;
+  uint64_t best;
+  uint64_t generation;
+  uint64_t evaluations;
+  uint64_t state_size;
+  uint32_t strategy;
+  uint16_t gene_bytes;
+  uint16_t cost_bytes;
+};
+
+}  // namespace snapshot
+
+// Contents of a snapshot, the spans point into the engine while writing and
+// into the mapped file while reading.
+struct snapshot_view_structure {
+  uint64_t seed = 0;
+  uint32_t run = 0;
+  uint64_t size = 0;
+  uint64_t dim = 0;
+  uint64_t best = 0;
+  uint64_t generation = 0;
+  uint64_t evaluations = 0;
+  uint32_t strategy = 0;
+  uint16_t gene_bytes = sizeof(double);
+  uint16_t cost_bytes = sizeof(double);
+  std::span<const double> min;
+  std::span<const double> max;
+  std::span<const double> costs;
+  std::span<const double> weights;
+  std::span<const double> state;
+};
+
+using snapshot_view_t = snapshot_view_structure;
+
+// Writes `snapshot` to `path` through a temporary file that is renamed into
+// place, a run killed while writing leaves the previous snapshot intact.
+void WriteSnapshot(const std::string &path, const snapshot_view_t &snapshot);
+
+// Read-only memory mapped snapshot written by WriteSnapshot.
+class Snapshot {
+ public:
+  explicit Snapshot(const std::string &path);
+  ~Snapshot();
+
+  Snapshot(Snapshot &&other) noexcept;
+  Snapshot &operator=(Snapshot &&other) noexcept;
+  Snapshot(const Snapshot &) = delete;
+  Snapshot &operator=(const Snapshot &) = delete;
+
+  [[nodiscard]] const snapshot_view_t &View() const;
+
+ private:
+  const unsigned char *data_ = nullptr;
+  size_t bytes_ = 0;
+  snapshot_view_t view_;
+};
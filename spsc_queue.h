@@ -0,0 +1,56 @@
+/*
+ * Created by kureii on 11/15/24.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <new>
+#include <utility>
+#include <vector>
+
+// Bounded lock-free queue for exactly one producer and one consumer thread.
+// Slots are constructed up front from a prototype, TryPush copy-assigns into
+// a slot and TryPop swaps the slot with the caller's value, so element types
+// that own memory (like std::vector) are not reallocated once warmed up.
+template <typename T>
+class SpscQueue {
+ public:
+  SpscQueue(size_t capacity, const T &prototype)
+      : slots_(capacity + 1, prototype) {}
+
+  SpscQueue(const SpscQueue &) = delete;
+  SpscQueue &operator=(const SpscQueue &) = delete;
+
+  // Returns false without blocking when the queue is full.
+  bool TryPush(const T &value) {
+    const auto tail = tail_.load(std::memory_order_relaxed);
+    const auto next = Next(tail);
+    if (next == head_.load(std::memory_order_acquire)) return false;
+
+    slots_[tail] = value;
+    tail_.store(next, std::memory_order_release);
+    return true;
+  }
+
+  // Returns false without blocking when the queue is empty.
+  bool TryPop(T &value) {
+    const auto head = head_.load(std::memory_order_relaxed);
+    if (head == tail_.load(std::memory_order_acquire)) return false;
+
+    using std::swap;
+    swap(slots_[head], value);
+    head_.store(Next(head), std::memory_order_release);
+    return true;
+  }
+
+ private:
+  std::vector<T> slots_;
+  alignas(64) std::atomic<size_t> head_ = 0;
+  alignas(64) std::atomic<size_t> tail_ = 0;
+
+  [[nodiscard]] size_t Next(size_t idx) const {
+    return idx + 1 == slots_.size() ? 0 : idx + 1;
+  }
+};
@@ -4,6 +4,8 @@
 
 #pragma once
 
+#include <array>
+#include <span>
 #include <vector>
 
 struct dif_evo_structure {
@@ -14,3 +16,102 @@ struct dif_evo_structure {
 };
 
 using de_t = dif_evo_structure;
+
+// Gene and cost types of a population. The mixed mode stores genes as float
+// but keeps costs, and with them the ranking and every reported cost, in
+// double.
+template <typename SCALAR, typename COST = SCALAR>
+struct precision_structure {
+  using scalar_type = SCALAR;
+  using cost_type = COST;
+};
+
+using double_precision_t = precision_structure<double>;
+using single_precision_t = precision_structure<float>;
+using mixed_precision_t = precision_structure<float, double>;
+
+// Whole population in one row-major matrix, individual i occupies
+// weights[i * dim, (i + 1) * dim). Genes are stored as SCALAR and costs as
+// COST, float genes with double costs being the mixed precision mode.
+template <typename SCALAR = double, typename COST = SCALAR>
+struct population_structure {
+  using scalar_type = SCALAR;
+  using cost_type = COST;
+
+  size_t size = 0;
+  size_t dim = 0;
+  std::vector<SCALAR> weights;
+  std::vector<COST> costs;
+  // index of the lowest cost, kept up to date by whoever writes costs
+  size_t best = 0;
+
+  void Resize(size_t new_size, size_t new_dim) {
+    size = new_size;
+    dim = new_dim;
+    weights.resize(size * dim);
+    costs.resize(size);
+  }
+
+  [[nodiscard]] std::span<SCALAR> Row(size_t i) {
+    return {weights.data() + i * dim, dim};
+  }
+  [[nodiscard]] std::span<const SCALAR> Row(size_t i) const {
+    return {weights.data() + i * dim, dim};
+  }
+  [[nodiscard]] const SCALAR *Data() const { return weights.data(); }
+};
+
+using pop_t = population_structure<>;
+
+// Same layout as pop_t for a dimension known at compile time, every
+// individual is a std::array<SCALAR, DIM>.
+template <size_t DIM, typename SCALAR = double, typename COST = SCALAR>
+struct fixed_population_structure {
+  using scalar_type = SCALAR;
+  using cost_type = COST;
+
+  static constexpr size_t dim = DIM;
+  size_t size = 0;
+  std::vector<std::array<SCALAR, DIM>> weights;
+  std::vector<COST> costs;
+  size_t best = 0;
+
+  void Resize(size_t new_size, size_t /*new_dim*/) {
+    size = new_size;
+    weights.resize(size);
+    costs.resize(size);
+  }
+
+  [[nodiscard]] std::span<SCALAR, DIM> Row(size_t i) { return weights[i]; }
+  [[nodiscard]] std::span<const SCALAR, DIM> Row(size_t i) const {
+    return weights[i];
+  }
+  [[nodiscard]] const SCALAR *Data() const {
+    return weights.empty() ? nullptr : weights.front().data();
+  }
+};
+
+// Read-only window over `size` consecutive individuals of a population
+// matrix, handed to batched objective functions.
+template <typename SCALAR = double>
+struct population_view_structure {
+  const SCALAR *weights = nullptr;
+  size_t size = 0;
+  size_t dim = 0;
+
+  [[nodiscard]] std::span<const SCALAR> Row(size_t i) const {
+    return {weights + i * dim, dim};
+  }
+};
+
+using pop_view_t = population_view_structure<>;
+using float_pop_view_t = population_view_structure<float>;
+
+// Search space bounds, stored once per problem.
+template <typename SCALAR = double>
+struct limits_structure {
+  std::vector<SCALAR> min;
+  std::vector<SCALAR> max;
+};
+
+using limits_t = limits_structure<>;
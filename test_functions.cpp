@@ -8,17 +8,448 @@
 
 #include <cfloat>
 #include <cmath>
+#include <concepts>
+#include <limits>
+#include <numbers>
+#include <random>
+#include <stdexcept>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define TEST_FUNCTIONS_X86
+#endif
 
 namespace test_functions {
 
+namespace {
+
+// Costs are accumulated in COST, which lets the single precision batches
+// below sum float genes in double.
+template <typename SCALAR, typename COST = SCALAR>
+COST RosenbrockCost(const SCALAR *weight, size_t dim) {
+  COST cost = 0;
+  for (size_t i = 0; i < dim - 1; ++i) {
+    const COST x = weight[i];
+    const COST x_next = weight[i + 1];
+    const auto t = x_next - x * x;
+    cost += 100 * (t * t) + (x - 1) * (x - 1);
+  }
+  return cost;
+}
+
+template <typename SCALAR, typename COST = SCALAR>
+COST SphareCost(const SCALAR *weight, size_t dim) {
+  COST cost = 0;
+  for (size_t i = 0; i < dim; ++i) {
+    const COST x = weight[i];
+    cost += x * x;
+  }
+  return cost;
+}
+
+template <typename SCALAR, typename COST = SCALAR>
+COST SchefelCost(const SCALAR *weight, size_t dim) {
+  COST cost = 0;
+  for (size_t i = 0; i < dim; ++i) {
+    const COST x = weight[i];
+    cost += std::sin(std::sqrt(std::fabs(x)));
+  }
+  return cost;
+}
+
+template <typename SCALAR, typename COST = SCALAR>
+COST RastriginCost(const SCALAR *weight, size_t dim) {
+  COST cost = COST(10) * static_cast<COST>(dim);
+  for (size_t i = 0; i < dim; ++i) {
+    const COST x = weight[i];
+    cost += x * x - COST(10) * std::cos(COST(2 * std::numbers::pi) * x);
+  }
+  return cost;
+}
+
+template <typename SCALAR, typename COST = SCALAR>
+COST AckleyCost(const SCALAR *weight, size_t dim) {
+  COST squares = 0;
+  COST cosines = 0;
+  for (size_t i = 0; i < dim; ++i) {
+    const COST x = weight[i];
+    squares += x * x;
+    cosines += std::cos(COST(2 * std::numbers::pi) * x);
+  }
+  const auto n = static_cast<COST>(dim);
+  return COST(-20) * std::exp(COST(-0.2) * std::sqrt(squares / n)) -
+         std::exp(cosines / n) + COST(20) + std::numbers::e_v<COST>;
+}
+
+template <typename SCALAR, typename COST = SCALAR>
+COST GriewankCost(const SCALAR *weight, size_t dim) {
+  COST sum = 0;
+  COST product = 1;
+  for (size_t i = 0; i < dim; ++i) {
+    const COST x = weight[i];
+    sum += x * x;
+    product *= std::cos(x / std::sqrt(static_cast<COST>(i + 1)));
+  }
+  return COST(1) + sum / COST(4000) - product;
+}
+
+template <double (*COST)(const double *, size_t)>
+void ScalarBatch(pop_view_t population, std::span<double> costs,
+                 size_t first) {
+  for (size_t j = first; j < population.size; ++j) {
+    costs[j] = COST(population.Row(j).data(), population.dim);
+  }
+}
+
+enum class SimdLevel { kScalar, kAvx2, kAvx512 };
+
+SimdLevel DetectSimd() {
+#ifdef TEST_FUNCTIONS_X86
+  static const auto level = [] {
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) return SimdLevel::kAvx512;
+    if (__builtin_cpu_supports("avx2")) return SimdLevel::kAvx2;
+    return SimdLevel::kScalar;
+  }();
+  return level;
+#else
+  return SimdLevel::kScalar;
+#endif
+}
+
+#ifdef TEST_FUNCTIONS_X86
+
+// Lane k of a gather reads gene i of individual j + k, the kernels below
+// therefore accumulate the same terms in the same order as the scalar code.
+// This file is built with -ffp-contract=off, avx512f implies FMA and the
+// compiler would otherwise fuse the products into the sums.
+
+__attribute__((target("avx2"))) __m256i Avx2Offsets(size_t dim) {
+  const auto d = static_cast<long long>(dim);
+  return _mm256_set_epi64x(3 * d, 2 * d, d, 0);
+}
+
+__attribute__((target("avx2"))) size_t RosenbrockAvx2(
+    pop_view_t population, std::span<double> costs) {
+  const auto offsets = Avx2Offsets(population.dim);
+  const auto hundred = _mm256_set1_pd(100.0);
+  const auto one = _mm256_set1_pd(1.0);
+  size_t j = 0;
+  for (; j + 4 <= population.size; j += 4) {
+    const auto *base = population.Row(j).data();
+    auto cost = _mm256_setzero_pd();
+    auto x = _mm256_i64gather_pd(base, offsets, 8);
+    for (size_t i = 0; i + 1 < population.dim; ++i) {
+      const auto x_next = _mm256_i64gather_pd(base + i + 1, offsets, 8);
+      const auto t = _mm256_sub_pd(x_next, _mm256_mul_pd(x, x));
+      const auto u = _mm256_sub_pd(x, one);
+      cost = _mm256_add_pd(
+          cost, _mm256_add_pd(_mm256_mul_pd(hundred, _mm256_mul_pd(t, t)),
+                              _mm256_mul_pd(u, u)));
+      x = x_next;
+    }
+    _mm256_storeu_pd(costs.data() + j, cost);
+  }
+  return j;
+}
+
+__attribute__((target("avx2"))) size_t SphareAvx2(pop_view_t population,
+                                                  std::span<double> costs) {
+  const auto offsets = Avx2Offsets(population.dim);
+  size_t j = 0;
+  for (; j + 4 <= population.size; j += 4) {
+    const auto *base = population.Row(j).data();
+    auto cost = _mm256_setzero_pd();
+    for (size_t i = 0; i < population.dim; ++i) {
+      const auto x = _mm256_i64gather_pd(base + i, offsets, 8);
+      cost = _mm256_add_pd(cost, _mm256_mul_pd(x, x));
+    }
+    _mm256_storeu_pd(costs.data() + j, cost);
+  }
+  return j;
+}
+
+// There is no vector sin in the instruction set, so only |x| and sqrt run
+// in vector registers and sin is applied per lane.
+__attribute__((target("avx2"))) size_t SchefelAvx2(pop_view_t population,
+                                                   std::span<double> costs) {
+  const auto offsets = Avx2Offsets(population.dim);
+  const auto sign_mask = _mm256_set1_pd(-0.0);
+  alignas(32) double roots[4];
+  size_t j = 0;
+  for (; j + 4 <= population.size; j += 4) {
+    const auto *base = population.Row(j).data();
+    double cost[4] = {};
+    for (size_t i = 0; i < population.dim; ++i) {
+      const auto x = _mm256_i64gather_pd(base + i, offsets, 8);
+      _mm256_store_pd(roots, _mm256_sqrt_pd(_mm256_andnot_pd(sign_mask, x)));
+      for (int k = 0; k < 4; ++k) {
+        cost[k] += sin(roots[k]);
+      }
+    }
+    std::ranges::copy(cost, costs.begin() + j);
+  }
+  return j;
+}
+
+__attribute__((target("avx512f"))) __m512i Avx512Offsets(size_t dim) {
+  const auto d = static_cast<long long>(dim);
+  return _mm512_set_epi64(7 * d, 6 * d, 5 * d, 4 * d, 3 * d, 2 * d, d, 0);
+}
+
+__attribute__((target("avx512f"))) size_t RosenbrockAvx512(
+    pop_view_t population, std::span<double> costs) {
+  const auto offsets = Avx512Offsets(population.dim);
+  const auto hundred = _mm512_set1_pd(100.0);
+  const auto one = _mm512_set1_pd(1.0);
+  size_t j = 0;
+  for (; j + 8 <= population.size; j += 8) {
+    const auto *base = population.Row(j).data();
+    auto cost = _mm512_setzero_pd();
+    auto x = _mm512_i64gather_pd(offsets, base, 8);
+    for (size_t i = 0; i + 1 < population.dim; ++i) {
+      const auto x_next = _mm512_i64gather_pd(offsets, base + i + 1, 8);
+      const auto t = _mm512_sub_pd(x_next, _mm512_mul_pd(x, x));
+      const auto u = _mm512_sub_pd(x, one);
+      cost = _mm512_add_pd(
+          cost, _mm512_add_pd(_mm512_mul_pd(hundred, _mm512_mul_pd(t, t)),
+                              _mm512_mul_pd(u, u)));
+      x = x_next;
+    }
+    _mm512_storeu_pd(costs.data() + j, cost);
+  }
+  return j;
+}
+
+__attribute__((target("avx512f"))) size_t SphareAvx512(
+    pop_view_t population, std::span<double> costs) {
+  const auto offsets = Avx512Offsets(population.dim);
+  size_t j = 0;
+  for (; j + 8 <= population.size; j += 8) {
+    const auto *base = population.Row(j).data();
+    auto cost = _mm512_setzero_pd();
+    for (size_t i = 0; i < population.dim; ++i) {
+      const auto x = _mm512_i64gather_pd(offsets, base + i, 8);
+      cost = _mm512_add_pd(cost, _mm512_mul_pd(x, x));
+    }
+    _mm512_storeu_pd(costs.data() + j, cost);
+  }
+  return j;
+}
+
+__attribute__((target("avx512f"))) size_t SchefelAvx512(
+    pop_view_t population, std::span<double> costs) {
+  const auto offsets = Avx512Offsets(population.dim);
+  alignas(64) double roots[8];
+  size_t j = 0;
+  for (; j + 8 <= population.size; j += 8) {
+    const auto *base = population.Row(j).data();
+    double cost[8] = {};
+    for (size_t i = 0; i < population.dim; ++i) {
+      const auto x = _mm512_i64gather_pd(offsets, base + i, 8);
+      _mm512_store_pd(roots, _mm512_sqrt_pd(_mm512_abs_pd(x)));
+      for (int k = 0; k < 8; ++k) {
+        cost[k] += sin(roots[k]);
+      }
+    }
+    std::ranges::copy(cost, costs.begin() + j);
+  }
+  return j;
+}
+
+// Single precision kernels, the same gathers with twice the lanes and 32 bit
+// offsets. They accumulate in float like the scalar code with COST float.
+
+__attribute__((target("avx2"))) __m256i Avx2FloatOffsets(size_t dim) {
+  const auto d = static_cast<int>(dim);
+  return _mm256_set_epi32(7 * d, 6 * d, 5 * d, 4 * d, 3 * d, 2 * d, d, 0);
+}
+
+__attribute__((target("avx2"))) size_t RosenbrockFloatAvx2(
+    float_pop_view_t population, std::span<float> costs) {
+  const auto offsets = Avx2FloatOffsets(population.dim);
+  const auto hundred = _mm256_set1_ps(100.0f);
+  const auto one = _mm256_set1_ps(1.0f);
+  size_t j = 0;
+  for (; j + 8 <= population.size; j += 8) {
+    const auto *base = population.Row(j).data();
+    auto cost = _mm256_setzero_ps();
+    auto x = _mm256_i32gather_ps(base, offsets, 4);
+    for (size_t i = 0; i + 1 < population.dim; ++i) {
+      const auto x_next = _mm256_i32gather_ps(base + i + 1, offsets, 4);
+      const auto t = _mm256_sub_ps(x_next, _mm256_mul_ps(x, x));
+      const auto u = _mm256_sub_ps(x, one);
+      cost = _mm256_add_ps(
+          cost, _mm256_add_ps(_mm256_mul_ps(hundred, _mm256_mul_ps(t, t)),
+                              _mm256_mul_ps(u, u)));
+      x = x_next;
+    }
+    _mm256_storeu_ps(costs.data() + j, cost);
+  }
+  return j;
+}
+
+__attribute__((target("avx2"))) size_t SphareFloatAvx2(
+    float_pop_view_t population, std::span<float> costs) {
+  const auto offsets = Avx2FloatOffsets(population.dim);
+  size_t j = 0;
+  for (; j + 8 <= population.size; j += 8) {
+    const auto *base = population.Row(j).data();
+    auto cost = _mm256_setzero_ps();
+    for (size_t i = 0; i < population.dim; ++i) {
+      const auto x = _mm256_i32gather_ps(base + i, offsets, 4);
+      cost = _mm256_add_ps(cost, _mm256_mul_ps(x, x));
+    }
+    _mm256_storeu_ps(costs.data() + j, cost);
+  }
+  return j;
+}
+
+__attribute__((target("avx2"))) size_t SchefelFloatAvx2(
+    float_pop_view_t population, std::span<float> costs) {
+  const auto offsets = Avx2FloatOffsets(population.dim);
+  const auto sign_mask = _mm256_set1_ps(-0.0f);
+  alignas(32) float roots[8];
+  size_t j = 0;
+  for (; j + 8 <= population.size; j += 8) {
+    const auto *base = population.Row(j).data();
+    float cost[8] = {};
+    for (size_t i = 0; i < population.dim; ++i) {
+      const auto x = _mm256_i32gather_ps(base + i, offsets, 4);
+      _mm256_store_ps(roots, _mm256_sqrt_ps(_mm256_andnot_ps(sign_mask, x)));
+      for (int k = 0; k < 8; ++k) {
+        cost[k] += std::sin(roots[k]);
+      }
+    }
+    std::ranges::copy(cost, costs.begin() + j);
+  }
+  return j;
+}
+
+__attribute__((target("avx512f"))) __m512i Avx512FloatOffsets(size_t dim) {
+  const auto d = static_cast<int>(dim);
+  return _mm512_set_epi32(15 * d, 14 * d, 13 * d, 12 * d, 11 * d, 10 * d,
+                          9 * d, 8 * d, 7 * d, 6 * d, 5 * d, 4 * d, 3 * d,
+                          2 * d, d, 0);
+}
+
+__attribute__((target("avx512f"))) size_t RosenbrockFloatAvx512(
+    float_pop_view_t population, std::span<float> costs) {
+  const auto offsets = Avx512FloatOffsets(population.dim);
+  const auto hundred = _mm512_set1_ps(100.0f);
+  const auto one = _mm512_set1_ps(1.0f);
+  size_t j = 0;
+  for (; j + 16 <= population.size; j += 16) {
+    const auto *base = population.Row(j).data();
+    auto cost = _mm512_setzero_ps();
+    auto x = _mm512_i32gather_ps(offsets, base, 4);
+    for (size_t i = 0; i + 1 < population.dim; ++i) {
+      const auto x_next = _mm512_i32gather_ps(offsets, base + i + 1, 4);
+      const auto t = _mm512_sub_ps(x_next, _mm512_mul_ps(x, x));
+      const auto u = _mm512_sub_ps(x, one);
+      cost = _mm512_add_ps(
+          cost, _mm512_add_ps(_mm512_mul_ps(hundred, _mm512_mul_ps(t, t)),
+                              _mm512_mul_ps(u, u)));
+      x = x_next;
+    }
+    _mm512_storeu_ps(costs.data() + j, cost);
+  }
+  return j;
+}
+
+__attribute__((target("avx512f"))) size_t SphareFloatAvx512(
+    float_pop_view_t population, std::span<float> costs) {
+  const auto offsets = Avx512FloatOffsets(population.dim);
+  size_t j = 0;
+  for (; j + 16 <= population.size; j += 16) {
+    const auto *base = population.Row(j).data();
+    auto cost = _mm512_setzero_ps();
+    for (size_t i = 0; i < population.dim; ++i) {
+      const auto x = _mm512_i32gather_ps(offsets, base + i, 4);
+      cost = _mm512_add_ps(cost, _mm512_mul_ps(x, x));
+    }
+    _mm512_storeu_ps(costs.data() + j, cost);
+  }
+  return j;
+}
+
+__attribute__((target("avx512f"))) size_t SchefelFloatAvx512(
+    float_pop_view_t population, std::span<float> costs) {
+  const auto offsets = Avx512FloatOffsets(population.dim);
+  alignas(64) float roots[16];
+  size_t j = 0;
+  for (; j + 16 <= population.size; j += 16) {
+    const auto *base = population.Row(j).data();
+    float cost[16] = {};
+    for (size_t i = 0; i < population.dim; ++i) {
+      const auto x = _mm512_i32gather_ps(offsets, base + i, 4);
+      _mm512_store_ps(roots, _mm512_sqrt_ps(_mm512_abs_ps(x)));
+      for (int k = 0; k < 16; ++k) {
+        cost[k] += std::sin(roots[k]);
+      }
+    }
+    std::ranges::copy(cost, costs.begin() + j);
+  }
+  return j;
+}
+
+#endif
+
+using kernel_t = size_t (*)(pop_view_t, std::span<double>);
+using float_kernel_t = size_t (*)(float_pop_view_t, std::span<float>);
+
+// Rows the vector kernel for the CPU has evaluated, the caller does the
+// rest.
+template <typename KERNEL, typename VIEW, typename COST>
+size_t RunKernel(VIEW population, std::span<COST> costs,
+                 [[maybe_unused]] KERNEL avx2,
+                 [[maybe_unused]] KERNEL avx512) {
+#ifdef TEST_FUNCTIONS_X86
+  switch (DetectSimd()) {
+    case SimdLevel::kAvx512:
+      return avx512(population, costs);
+    case SimdLevel::kAvx2:
+      return avx2(population, costs);
+    case SimdLevel::kScalar:
+      break;
+  }
+#endif
+  return 0;
+}
+
+template <double (*COST)(const double *, size_t)>
+void DispatchBatch(pop_view_t population, std::span<double> costs,
+                   kernel_t avx2, kernel_t avx512) {
+  ScalarBatch<COST>(population, costs,
+                    RunKernel(population, costs, avx2, avx512));
+}
+
+// Single precision batch, rows with fewer than `min_dim` genes get the
+// highest cost. Only float costs go through the kernels, double sums would
+// not get more lanes than the double kernels.
+template <auto COST_FN, typename COST>
+void FloatBatch(float_pop_view_t population, std::span<COST> costs,
+                size_t min_dim, [[maybe_unused]] float_kernel_t avx2 = nullptr,
+                [[maybe_unused]] float_kernel_t avx512 = nullptr) {
+  if (population.dim < min_dim) {
+    std::ranges::fill(costs.first(population.size),
+                      std::numeric_limits<COST>::max());
+    return;
+  }
+  size_t done = 0;
+  if constexpr (std::same_as<COST, float>) {
+    if (avx2 && avx512) done = RunKernel(population, costs, avx2, avx512);
+  }
+  for (size_t j = done; j < population.size; ++j) {
+    costs[j] = COST_FN(population.Row(j).data(), population.dim);
+  }
+}
+
+}  // namespace
+
 void Rosenbrock(de_t *des) {
   if (des->weight.size() > 1) {
-    if (des->cost != 0) des->cost = 0;
-    for (size_t i = 0; i < des->weight.size() - 1; ++i) {
-      const auto x = des->weight[i];
-      const auto x_next = des->weight[i + 1];
-      des->cost = 100 * pow(x_next - pow(x, 2), 2) + pow(x - 1, 2);
-    }
+    des->cost = RosenbrockCost(des->weight.data(), des->weight.size());
   } else {
     des->cost = DBL_MAX;
   }
@@ -26,10 +457,7 @@ void Rosenbrock(de_t *des) {
 
 void Sphare(de_t *des) {
   if (!des->weight.empty()) {
-    if (des->cost != 0) des->cost = 0;
-    std::ranges::for_each(des->weight, [&des](auto &v) {
-        des->cost += pow(v, 2);
-    });
+    des->cost = SphareCost(des->weight.data(), des->weight.size());
   } else {
     des->cost = DBL_MAX;
   }
@@ -37,13 +465,203 @@ void Sphare(de_t *des) {
 
 void Schefel(de_t *des) {
   if (!des->weight.empty()) {
-    if (des->cost != 0) des->cost = 0;
-    std::ranges::for_each(des->weight, [&des](auto &v) {
-        des->cost += sin(sqrt(fabs(v)));
-    });
+    des->cost = SchefelCost(des->weight.data(), des->weight.size());
   } else {
     des->cost = DBL_MAX;
   }
 }
 
-}
\ No newline at end of file
+void Rastrigin(de_t *des) {
+  if (!des->weight.empty()) {
+    des->cost = RastriginCost(des->weight.data(), des->weight.size());
+  } else {
+    des->cost = DBL_MAX;
+  }
+}
+
+void Ackley(de_t *des) {
+  if (!des->weight.empty()) {
+    des->cost = AckleyCost(des->weight.data(), des->weight.size());
+  } else {
+    des->cost = DBL_MAX;
+  }
+}
+
+void Griewank(de_t *des) {
+  if (!des->weight.empty()) {
+    des->cost = GriewankCost(des->weight.data(), des->weight.size());
+  } else {
+    des->cost = DBL_MAX;
+  }
+}
+
+#ifdef TEST_FUNCTIONS_X86
+#define TEST_FUNCTIONS_KERNELS(name) name##Avx2, name##Avx512
+#define TEST_FUNCTIONS_FLOAT_KERNELS(name) name##FloatAvx2, name##FloatAvx512
+#else
+#define TEST_FUNCTIONS_KERNELS(name) nullptr, nullptr
+#define TEST_FUNCTIONS_FLOAT_KERNELS(name) nullptr, nullptr
+#endif
+
+void RosenbrockBatch(pop_view_t population, std::span<double> costs) {
+  if (population.dim > 1) {
+    DispatchBatch<RosenbrockCost>(population, costs,
+                                  TEST_FUNCTIONS_KERNELS(Rosenbrock));
+  } else {
+    std::ranges::fill(costs.first(population.size), DBL_MAX);
+  }
+}
+
+void SphareBatch(pop_view_t population, std::span<double> costs) {
+  if (population.dim > 0) {
+    DispatchBatch<SphareCost>(population, costs,
+                              TEST_FUNCTIONS_KERNELS(Sphare));
+  } else {
+    std::ranges::fill(costs.first(population.size), DBL_MAX);
+  }
+}
+
+void SchefelBatch(pop_view_t population, std::span<double> costs) {
+  if (population.dim > 0) {
+    DispatchBatch<SchefelCost>(population, costs,
+                               TEST_FUNCTIONS_KERNELS(Schefel));
+  } else {
+    std::ranges::fill(costs.first(population.size), DBL_MAX);
+  }
+}
+
+void RastriginBatch(pop_view_t population, std::span<double> costs) {
+  if (population.dim > 0) {
+    ScalarBatch<RastriginCost>(population, costs, 0);
+  } else {
+    std::ranges::fill(costs.first(population.size), DBL_MAX);
+  }
+}
+
+void AckleyBatch(pop_view_t population, std::span<double> costs) {
+  if (population.dim > 0) {
+    ScalarBatch<AckleyCost>(population, costs, 0);
+  } else {
+    std::ranges::fill(costs.first(population.size), DBL_MAX);
+  }
+}
+
+void GriewankBatch(pop_view_t population, std::span<double> costs) {
+  if (population.dim > 0) {
+    ScalarBatch<GriewankCost>(population, costs, 0);
+  } else {
+    std::ranges::fill(costs.first(population.size), DBL_MAX);
+  }
+}
+
+template <typename COST>
+void RosenbrockBatchFloat(float_pop_view_t population, std::span<COST> costs) {
+  FloatBatch<RosenbrockCost<float, COST>>(
+      population, costs, 2, TEST_FUNCTIONS_FLOAT_KERNELS(Rosenbrock));
+}
+
+template <typename COST>
+void SphareBatchFloat(float_pop_view_t population, std::span<COST> costs) {
+  FloatBatch<SphareCost<float, COST>>(population, costs, 1,
+                                      TEST_FUNCTIONS_FLOAT_KERNELS(Sphare));
+}
+
+template <typename COST>
+void SchefelBatchFloat(float_pop_view_t population, std::span<COST> costs) {
+  FloatBatch<SchefelCost<float, COST>>(population, costs, 1,
+                                       TEST_FUNCTIONS_FLOAT_KERNELS(Schefel));
+}
+
+template <typename COST>
+void RastriginBatchFloat(float_pop_view_t population, std::span<COST> costs) {
+  FloatBatch<RastriginCost<float, COST>>(population, costs, 1);
+}
+
+template <typename COST>
+void AckleyBatchFloat(float_pop_view_t population, std::span<COST> costs) {
+  FloatBatch<AckleyCost<float, COST>>(population, costs, 1);
+}
+
+template <typename COST>
+void GriewankBatchFloat(float_pop_view_t population, std::span<COST> costs) {
+  FloatBatch<GriewankCost<float, COST>>(population, costs, 1);
+}
+
+#define TEST_FUNCTIONS_FLOAT_BATCH(name)                                      \
+  template void name##BatchFloat<float>(float_pop_view_t, std::span<float>);  \
+  template void name##BatchFloat<double>(float_pop_view_t, std::span<double>)
+
+TEST_FUNCTIONS_FLOAT_BATCH(Rosenbrock);
+TEST_FUNCTIONS_FLOAT_BATCH(Sphare);
+TEST_FUNCTIONS_FLOAT_BATCH(Schefel);
+TEST_FUNCTIONS_FLOAT_BATCH(Rastrigin);
+TEST_FUNCTIONS_FLOAT_BATCH(Ackley);
+TEST_FUNCTIONS_FLOAT_BATCH(Griewank);
+
+ShiftedRotated::ShiftedRotated(batch_function_t base, size_t dim, double min,
+                               double max, uint64_t seed, bool rotate)
+    : base_(base), dim_(dim), shift_(dim) {
+  if (dim == 0 || !(min < max)) {
+    throw std::invalid_argument(
+        "ShiftedRotated needs a dimension and min < max");
+  }
+  std::mt19937_64 gen(seed);
+  std::uniform_real_distribution<> uniform(min, max);
+  for (auto &o : shift_) {
+    o = uniform(gen);
+  }
+  if (!rotate) return;
+
+  // Gram-Schmidt on a gaussian matrix gives a uniformly random rotation
+  std::normal_distribution<> normal;
+  rotation_.resize(dim * dim);
+  for (auto &m : rotation_) {
+    m = normal(gen);
+  }
+  for (size_t r = 0; r < dim; ++r) {
+    auto *row = rotation_.data() + r * dim;
+    for (size_t k = 0; k < r; ++k) {
+      const auto *prev = rotation_.data() + k * dim;
+      double dot = 0;
+      for (size_t i = 0; i < dim; ++i) dot += row[i] * prev[i];
+      for (size_t i = 0; i < dim; ++i) row[i] -= dot * prev[i];
+    }
+    double norm = 0;
+    for (size_t i = 0; i < dim; ++i) norm += row[i] * row[i];
+    norm = sqrt(norm);
+    for (size_t i = 0; i < dim; ++i) row[i] /= norm;
+  }
+}
+
+void ShiftedRotated::operator()(pop_view_t population,
+                                std::span<double> costs) const {
+  if (population.dim != dim_) {
+    throw std::invalid_argument(
+        "population dimension does not match ShiftedRotated");
+  }
+  thread_local std::vector<double> shifted;
+  thread_local std::vector<double> transformed;
+  shifted.resize(dim_);
+  transformed.resize(population.size * dim_);
+
+  for (size_t j = 0; j < population.size; ++j) {
+    const auto x = population.Row(j);
+    auto *z = transformed.data() + j * dim_;
+    if (rotation_.empty()) {
+      for (size_t i = 0; i < dim_; ++i) z[i] = x[i] - shift_[i];
+      continue;
+    }
+    for (size_t i = 0; i < dim_; ++i) shifted[i] = x[i] - shift_[i];
+    for (size_t r = 0; r < dim_; ++r) {
+      const auto *row = rotation_.data() + r * dim_;
+      double sum = 0;
+      for (size_t i = 0; i < dim_; ++i) sum += row[i] * shifted[i];
+      z[r] = sum;
+    }
+  }
+  base_(pop_view_t{transformed.data(), population.size, dim_}, costs);
+}
+
+std::span<const double> ShiftedRotated::Shift() const { return shift_; }
+
+}
@@ -4,6 +4,13 @@
 
 #pragma once
 
+#include <cmath>
+#include <cstdint>
+#include <numbers>
+#include <span>
+#include <vector>
+
+#include "delta_objective.h"
 #include "structures.h"
 
 namespace test_functions {
@@ -14,5 +21,96 @@ void Sphare(de_t *des);
 
 void Schefel(de_t *des);
 
+void Rastrigin(de_t *des);
+
+void Ackley(de_t *des);
+
+void Griewank(de_t *des);
+
+// Batched versions, costs[i] receives the cost of population.Row(i). They
+// evaluate several individuals per instruction with AVX-512 or AVX2 when the
+// CPU supports it and fall back to scalar code otherwise.
+void RosenbrockBatch(pop_view_t population, std::span<double> costs);
+
+void SphareBatch(pop_view_t population, std::span<double> costs);
+
+void SchefelBatch(pop_view_t population, std::span<double> costs);
+
+// cos and exp have no vector instruction either, these evaluate row by row.
+void RastriginBatch(pop_view_t population, std::span<double> costs);
+
+void AckleyBatch(pop_view_t population, std::span<double> costs);
+
+void GriewankBatch(pop_view_t population, std::span<double> costs);
+
+// Single precision batches for engines with float genes. The cost is
+// accumulated in COST: float, or double for the mixed precision mode. They
+// exist for COST float and double only. With COST float, Rosenbrock, Sphare
+// and Schefel evaluate 16 or 8 individuals per instruction like the double
+// batches do 8 or 4, everything else evaluates row by row.
+template <typename COST>
+void RosenbrockBatchFloat(float_pop_view_t population, std::span<COST> costs);
+
+template <typename COST>
+void SphareBatchFloat(float_pop_view_t population, std::span<COST> costs);
+
+template <typename COST>
+void SchefelBatchFloat(float_pop_view_t population, std::span<COST> costs);
+
+template <typename COST>
+void RastriginBatchFloat(float_pop_view_t population, std::span<COST> costs);
+
+template <typename COST>
+void AckleyBatchFloat(float_pop_view_t population, std::span<COST> costs);
+
+template <typename COST>
+void GriewankBatchFloat(float_pop_view_t population, std::span<COST> costs);
+
+// Per-gene and per-neighbour terms of the separable functions above.
+inline double SphareTerm(double x) { return x * x; }
+
+inline double SchefelTerm(double x) {
+  return std::sin(std::sqrt(std::fabs(x)));
+}
+
+inline double RastriginTerm(double x) {
+  return 10.0 + x * x - 10.0 * std::cos(2.0 * std::numbers::pi * x);
+}
+
+inline double RosenbrockTerm(double x, double x_next) {
+  const auto t = x_next - x * x;
+  return 100 * (t * t) + (x - 1) * (x - 1);
+}
+
+// Batched objectives that also update costs incrementally, see
+// DeltaObjective.
+using SphareDelta = SeparableObjective<SphareBatch, SphareTerm>;
+using SchefelDelta = SeparableObjective<SchefelBatch, SchefelTerm>;
+using RastriginDelta = SeparableObjective<RastriginBatch, RastriginTerm>;
+using RosenbrockDelta = ChainedObjective<RosenbrockBatch, RosenbrockTerm>;
+
+using batch_function_t = void (*)(pop_view_t, std::span<double>);
+
+// CEC style variant f(M (x - o)) of a batched function: the optimum is moved
+// to a shift o drawn uniformly from [min, max] and, unless `rotate` is false,
+// the variables are mixed by a random rotation M, so separable functions
+// stop being separable. Everything is derived from `seed`. Safe to call
+// from several threads at once.
+class ShiftedRotated {
+ public:
+  ShiftedRotated(batch_function_t base, size_t dim, double min, double max,
+                 uint64_t seed, bool rotate = true);
+
+  void operator()(pop_view_t population, std::span<double> costs) const;
+
+  [[nodiscard]] std::span<const double> Shift() const;
+
+ private:
+  batch_function_t base_;
+  size_t dim_;
+  std::vector<double> shift_;
+  // row major dim x dim, empty when not rotated
+  std::vector<double> rotation_;
+};
 
-};
\ No newline at end of file
+};
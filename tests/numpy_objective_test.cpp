@@ -0,0 +1,232 @@
+/*
+ * Created by kureii on 11/15/24.
+ */
+
+// Runs NumpyObjective against NumPy callables in an embedded interpreter:
+// the population reaches Python as a read-only view of the engine's genes,
+// costs come back as a return value of any dtype or through `out`, and
+// results of the wrong size or writes to the genes are errors.
+
+#include "numpy_objective.h"
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "diff_evo.h"
+#include "test_functions.h"
+
+namespace {
+
+constexpr size_t kSize = 13;
+constexpr size_t kDim = 5;
+
+// Every callable notes how it saw its input in `seen`.
+constexpr const char *kScript = R"(
+import numpy as np
+
+seen = {}
+
+def note(x):
+    seen['address'] = x.__array_interface__['data'][0]
+    seen['writeable'] = bool(x.flags.writeable)
+    seen['shape'] = x.shape
+    seen['dtype'] = str(x.dtype)
+
+def squares(x):
+    note(x)
+    return (x * x).sum(axis=1)
+
+def squares_float32(x):
+    note(x)
+    return (x * x).sum(axis=1).astype(np.float32)
+
+def squares_list(x):
+    note(x)
+    return [float(v) for v in (x * x).sum(axis=1)]
+
+def squares_column(x):
+    note(x)
+    return (x * x).sum(axis=1, keepdims=True)
+
+def squares_out(x, out):
+    note(x)
+    seen['out_address'] = out.__array_interface__['data'][0]
+    seen['out_shape'] = out.shape
+    seen['out_dtype'] = str(out.dtype)
+    np.sum(x * x, axis=1, out=out)
+
+def too_short(x):
+    return (x * x).sum(axis=1)[:-1]
+
+def writes_genes(x):
+    x[0, 0] = 1.0
+    return (x * x).sum(axis=1)
+)";
+
+PyObject *module_dict = nullptr;
+
+int failures = 0;
+
+void Expect(const std::string &name, bool condition) {
+  if (condition) return;
+  std::fprintf(stderr, "%s failed\n", name.c_str());
+  ++failures;
+}
+
+PyObject *Callable(const char *name) {
+  return PyDict_GetItemString(module_dict, name);
+}
+
+PyObject *Seen(const char *key) {
+  return PyDict_GetItemString(PyDict_GetItemString(module_dict, "seen"), key);
+}
+
+std::string SeenString(const char *key) {
+  PyObject *value = Seen(key);
+  if (value == nullptr) return {};
+  PyObject *text = PyObject_Str(value);
+  std::string string = PyUnicode_AsUTF8(text);
+  Py_DECREF(text);
+  return string;
+}
+
+uintptr_t SeenAddress(const char *key) {
+  PyObject *value = Seen(key);
+  return value ? static_cast<uintptr_t>(PyLong_AsUnsignedLongLong(value)) : 0;
+}
+
+template <typename SCALAR>
+std::vector<SCALAR> Genes() {
+  std::vector<SCALAR> genes(kSize * kDim);
+  for (size_t g = 0; g < genes.size(); ++g) {
+    genes[g] = static_cast<SCALAR>(0.25 * static_cast<double>(g % 17) - 2.0);
+  }
+  return genes;
+}
+
+// Calls `name` on a kSize x kDim population and compares the costs with
+// the sum of squares, `tolerance` relative to it.
+template <typename SCALAR, typename COST>
+void ExpectSquares(const char *name, bool out_parameter, double tolerance) {
+  const auto genes = Genes<SCALAR>();
+  std::vector<COST> costs(kSize, COST(-1));
+  const population_view_structure<SCALAR> population{genes.data(), kSize,
+                                                     kDim};
+  NumpyObjective(Callable(name), out_parameter)(population,
+                                                std::span<COST>(costs));
+
+  const std::string label = std::string(name) + " " +
+                            (sizeof(SCALAR) == 4 ? "float" : "double") +
+                            " genes " +
+                            (sizeof(COST) == 4 ? "float" : "double") +
+                            " costs";
+  for (size_t j = 0; j < kSize; ++j) {
+    double expected = 0;
+    for (size_t i = 0; i < kDim; ++i) {
+      const double x = genes[j * kDim + i];
+      expected += x * x;
+    }
+    Expect(label + " cost " + std::to_string(j),
+           std::fabs(costs[j] - expected) <= tolerance * (1 + expected));
+  }
+
+  const auto dtype = sizeof(SCALAR) == 4 ? "float32" : "float64";
+  Expect(label + " view", SeenAddress("address") ==
+                              reinterpret_cast<uintptr_t>(genes.data()));
+  Expect(label + " read-only", SeenString("writeable") == "False");
+  Expect(label + " shape", SeenString("shape") == "(13, 5)");
+  Expect(label + " dtype", SeenString("dtype") == dtype);
+  if (out_parameter) {
+    Expect(label + " out view", SeenAddress("out_address") ==
+                                    reinterpret_cast<uintptr_t>(costs.data()));
+    Expect(label + " out shape", SeenString("out_shape") == "(13,)");
+    Expect(label + " out dtype", SeenString("out_dtype") ==
+                                     (sizeof(COST) == 4 ? "float32"
+                                                        : "float64"));
+  }
+}
+
+void ExpectThrows(const char *name) {
+  const auto genes = Genes<double>();
+  std::vector<double> costs(kSize);
+  try {
+    NumpyObjective(Callable(name))(pop_view_t{genes.data(), kSize, kDim},
+                                   std::span<double>(costs));
+  } catch (const std::runtime_error &) {
+    return;
+  }
+  Expect(std::string(name) + " throws", false);
+}
+
+// Runs of the same seed on four threads, the main thread letting go of the
+// GIL while it waits, with the NumPy and the C++ sphere.
+std::vector<de_t> Run(bool numpy) {
+  DiffEvo de(3);
+  de.GenerateInitPopulation(kDim, 40);
+  de.AddMinLimits(-5.0);
+  de.AddMaxLimits(5.0);
+  de.SetThreads(4);
+  if (!numpy) return de.Rand1(4000, 0.5, 0.9, test_functions::SphareBatch);
+
+  const NumpyObjective objective(Callable("squares"));
+  std::vector<de_t> output;
+  Py_BEGIN_ALLOW_THREADS
+  output = de.Rand1(4000, 0.5, 0.9, objective);
+  Py_END_ALLOW_THREADS
+  return output;
+}
+
+void ExpectRun() {
+  const auto output = Run(true);
+  const auto expected = Run(false);
+  Expect("run generations",
+         !output.empty() && output.size() == expected.size());
+  if (output.size() != expected.size()) return;
+  for (size_t g = 0; g < output.size(); ++g) {
+    Expect("run generation " + std::to_string(g),
+           std::fabs(output[g].cost - expected[g].cost) <=
+               1e-12 * (1 + expected[g].cost));
+  }
+}
+
+}  // namespace
+
+int main() {
+  Py_Initialize();
+  PyObject *module = PyImport_AddModule("__main__");
+  module_dict = PyModule_GetDict(module);
+  PyObject *result =
+      PyRun_String(kScript, Py_file_input, module_dict, module_dict);
+  if (result == nullptr) {
+    PyErr_Print();
+    return EXIT_FAILURE;
+  }
+  Py_DECREF(result);
+
+  try {
+    ExpectSquares<double, double>("squares", false, 1e-12);
+    ExpectSquares<double, double>("squares_float32", false, 1e-6);
+    ExpectSquares<double, double>("squares_list", false, 1e-12);
+    ExpectSquares<double, double>("squares_column", false, 1e-12);
+    ExpectSquares<double, double>("squares_out", true, 1e-12);
+    ExpectSquares<float, float>("squares", false, 1e-6);
+    ExpectSquares<float, float>("squares_out", true, 1e-6);
+    ExpectSquares<float, double>("squares", false, 1e-6);
+    ExpectSquares<float, double>("squares_out", true, 1e-6);
+    ExpectThrows("too_short");
+    ExpectThrows("writes_genes");
+    ExpectRun();
+  } catch (const std::exception &e) {
+    std::fprintf(stderr, "%s\n", e.what());
+    ++failures;
+  }
+
+  // every objective is gone, so nothing needs the interpreter any more
+  Py_FinalizeEx();
+  return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
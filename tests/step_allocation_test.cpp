@@ -0,0 +1,176 @@
+/*
+ * Created by kureii on 11/15/24.
+ */
+
+// Counts heap allocations through a replaced global operator new: once an
+// engine has run a generation, further generations must not allocate, and
+// Continue allocates its records before the generation loop.
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <span>
+#include <utility>
+#include <vector>
+
+#include "de_engine.h"
+#include "diff_evo.h"
+#include "test_functions.h"
+
+namespace {
+
+std::atomic<size_t> allocations{0};
+
+void *Allocate(std::size_t size, std::size_t alignment) {
+  allocations.fetch_add(1, std::memory_order_relaxed);
+  size = size == 0 ? 1 : size;
+  void *memory = alignment <= alignof(std::max_align_t)
+                     ? std::malloc(size)
+                     : std::aligned_alloc(
+                           alignment, (size + alignment - 1) / alignment *
+                                          alignment);
+  if (memory == nullptr) throw std::bad_alloc();
+  return memory;
+}
+
+}  // namespace
+
+void *operator new(std::size_t size) {
+  return Allocate(size, alignof(std::max_align_t));
+}
+void *operator new(std::size_t size, std::align_val_t alignment) {
+  return Allocate(size, static_cast<std::size_t>(alignment));
+}
+void operator delete(void *memory) noexcept { std::free(memory); }
+void operator delete(void *memory, std::size_t) noexcept { std::free(memory); }
+void operator delete(void *memory, std::align_val_t) noexcept {
+  std::free(memory);
+}
+void operator delete(void *memory, std::size_t, std::align_val_t) noexcept {
+  std::free(memory);
+}
+
+namespace {
+
+constexpr size_t kWarmup = 2;
+constexpr size_t kGenerations = 50;
+
+// Engine on a fixed population that has already run kWarmup generations.
+template <typename MUTATION, typename FUN>
+DiffEvoEngine<MUTATION> WarmEngine(MUTATION mutation, FUN &fun,
+                                   ParallelRunner *runner) {
+  DiffEvo de(7);
+  de.GenerateInitPopulation(10, 40);
+  de.AddMinLimits(-5.0);
+  de.AddMaxLimits(5.0);
+
+  DiffEvoEngine<MUTATION> engine(std::move(mutation), BinomialCrossover{},
+                                 de.GetLimits(), 7, runner);
+  engine.Init(de.GetInitPopulation(), fun);
+  for (size_t g = 0; g < kWarmup; ++g) engine.Step(fun);
+  return engine;
+}
+
+// Allocations of kGenerations calls to Step on a warm engine.
+template <typename MUTATION, typename FUN>
+size_t StepAllocations(MUTATION mutation, FUN fun, ParallelRunner *runner) {
+  auto engine = WarmEngine(std::move(mutation), fun, runner);
+  const auto before = allocations.load();
+  for (size_t g = 0; g < kGenerations; ++g) engine.Step(fun);
+  return allocations.load() - before;
+}
+
+// Batch objective noting the allocation count at each of its calls, which
+// come once per generation on a single thread.
+struct allocation_probe_structure {
+  std::vector<size_t> *seen;
+
+  void operator()(pop_view_t population, std::span<double> costs) const {
+    test_functions::SphareBatch(population, costs);
+    if (seen->size() < seen->capacity()) {
+      seen->push_back(allocations.load());
+    }
+  }
+};
+
+// Generations of Continue(iterations) on a warm engine during which
+// anything was allocated.
+template <typename MUTATION>
+size_t ContinueAllocations(MUTATION mutation, size_t iterations) {
+  std::vector<size_t> seen;
+  seen.reserve(iterations);
+  allocation_probe_structure probe{&seen};
+  auto engine = WarmEngine(std::move(mutation), probe, nullptr);
+
+  seen.clear();
+  engine.Continue(iterations, probe);
+  size_t count = 0;
+  for (size_t g = 1; g < seen.size(); ++g) {
+    if (seen[g] != seen[g - 1]) ++count;
+  }
+  return count;
+}
+
+int failures = 0;
+
+void Expect(const char *name, size_t count, size_t limit) {
+  if (count <= limit) return;
+  std::fprintf(stderr, "%s: %zu, at most %zu expected\n", name, count,
+               limit);
+  ++failures;
+}
+
+}  // namespace
+
+int main() {
+  ParallelRunner threads;
+  threads.SetThreads(4);
+
+  for (auto *runner : {static_cast<ParallelRunner *>(nullptr), &threads}) {
+    Expect("rand1 batch step allocations",
+           StepAllocations(Rand1Mutation{{0.5, 0.9}},
+                           test_functions::SphareBatch, runner),
+           0);
+    Expect("rand1 individual step allocations",
+           StepAllocations(Rand1Mutation{{0.5, 0.9}}, test_functions::Sphare,
+                           runner),
+           0);
+    Expect("best1 batch step allocations",
+           StepAllocations(Best1Mutation{{0.5, 0.9}},
+                           test_functions::RastriginBatch, runner),
+           0);
+    Expect("best1 individual step allocations",
+           StepAllocations(Best1Mutation{{0.5, 0.9}},
+                           test_functions::Rastrigin, runner),
+           0);
+    Expect("best1 delta step allocations",
+           StepAllocations(Best1Mutation{{0.5, 0.9}},
+                           test_functions::RastriginDelta{}, runner),
+           0);
+    Expect("jde batch step allocations",
+           StepAllocations(JdeMutation{{0.5, 0.9}, 0.1, 0.1, {}},
+                           test_functions::RosenbrockBatch, runner),
+           0);
+    Expect("lshade batch step allocations",
+           StepAllocations(LshadeMutation{4000},
+                           test_functions::RastriginBatch, runner),
+           0);
+  }
+
+  // records are allocated before the loop, only a shrinking population
+  // needs a few more on the way
+  for (const size_t iterations : {2000, 20000}) {
+    Expect("rand1 continue allocating generations",
+           ContinueAllocations(Rand1Mutation{{0.5, 0.9}}, iterations), 0);
+    Expect("best1 continue allocating generations",
+           ContinueAllocations(Best1Mutation{{0.5, 0.9}}, iterations), 0);
+    Expect("jde continue allocating generations",
+           ContinueAllocations(JdeMutation{{0.5, 0.9}, 0.1, 0.1, {}},
+                               iterations),
+           0);
+    Expect("lshade continue allocating generations",
+           ContinueAllocations(LshadeMutation{iterations}, iterations), 8);
+  }
+  return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,83 @@
+/*
+ * Created by kureii on 11/15/24.
+ */
+
+#include "thread_pool.h"
+
+#include <algorithm>
+#include <utility>
+
+ThreadPool::ThreadPool(size_t threads) {
+  const auto workers = std::max<size_t>(threads, 1) - 1;
+  workers_.reserve(workers);
+  for (size_t i = 0; i < workers; ++i) {
+    workers_.emplace_back(&ThreadPool::WorkerLoop, this, i + 1);
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard lock(mutex_);
+    stop_ = true;
+  }
+  start_cv_.notify_all();
+  for (auto &worker : workers_) {
+    worker.join();
+  }
+}
+
+size_t ThreadPool::Size() const { return workers_.size() + 1; }
+
+void ThreadPool::Run(size_t count, void *ctx, invoke_t invoke) {
+  {
+    std::lock_guard lock(mutex_);
+    count_ = count;
+    ctx_ = ctx;
+    invoke_ = invoke;
+    pending_ = workers_.size();
+    ++ticket_;
+  }
+  start_cv_.notify_all();
+
+  RunChunk(0);
+
+  std::unique_lock lock(mutex_);
+  done_cv_.wait(lock, [this] { return pending_ == 0; });
+  if (error_) {
+    std::rethrow_exception(std::exchange(error_, nullptr));
+  }
+}
+
+void ThreadPool::RunChunk(size_t chunk) {
+  const auto chunks = Size();
+  const auto begin = count_ * chunk / chunks;
+  const auto end = count_ * (chunk + 1) / chunks;
+  if (begin >= end) return;
+
+  try {
+    invoke_(ctx_, chunk, begin, end);
+  } catch (...) {
+    std::lock_guard lock(mutex_);
+    if (!error_) error_ = std::current_exception();
+  }
+}
+
+void ThreadPool::WorkerLoop(size_t chunk) {
+  size_t seen = 0;
+  while (true) {
+    {
+      std::unique_lock lock(mutex_);
+      start_cv_.wait(lock, [&] { return stop_ || ticket_ != seen; });
+      if (stop_) return;
+      seen = ticket_;
+    }
+
+    RunChunk(chunk);
+
+    {
+      std::lock_guard lock(mutex_);
+      --pending_;
+    }
+    done_cv_.notify_one();
+  }
+}
@@ -0,0 +1,57 @@
+/*
+ * Created by kureii on 11/15/24.
+ */
+
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// Fixed set of worker threads that split an index range into one chunk per
+// thread. ParallelFor blocks until every chunk is finished, so each call is
+// a barrier.
+class ThreadPool {
+ public:
+  explicit ThreadPool(size_t threads);
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool &) = delete;
+  ThreadPool &operator=(const ThreadPool &) = delete;
+
+  // Number of chunks a ParallelFor is split into, the calling thread included.
+  [[nodiscard]] size_t Size() const;
+
+  // Calls task(chunk, begin, end) for every chunk of [0, count). The first
+  // exception thrown by a chunk is rethrown once all chunks have finished.
+  template <typename TASK>
+  void ParallelFor(size_t count, TASK &&task) {
+    Run(count, &task, [](void *ctx, size_t chunk, size_t begin, size_t end) {
+      (*static_cast<std::remove_reference_t<TASK> *>(ctx))(chunk, begin, end);
+    });
+  }
+
+ private:
+  using invoke_t = void (*)(void *, size_t, size_t, size_t);
+
+  std::vector<std::thread> workers_;
+  std::mutex mutex_;
+  std::condition_variable start_cv_;
+  std::condition_variable done_cv_;
+  size_t ticket_ = 0;
+  size_t pending_ = 0;
+  bool stop_ = false;
+
+  size_t count_ = 0;
+  void *ctx_ = nullptr;
+  invoke_t invoke_ = nullptr;
+  std::exception_ptr error_;
+
+  void Run(size_t count, void *ctx, invoke_t invoke);
+  void RunChunk(size_t chunk);
+  void WorkerLoop(size_t chunk);
+};